@@ -0,0 +1,66 @@
+#include <cmath>
+#include "ConflictMatrix.h"
+
+// normalize an angle to [0, 2*pi)
+static double normalizeAngle(double angle)
+{
+    angle = std::fmod(angle, 2.0 * M_PI);
+    return angle < 0.0 ? angle + 2.0 * M_PI : angle;
+}
+
+ConflictMatrix::ConflictMatrix()
+{
+    _nLegs = 0;
+}
+
+void ConflictMatrix::build(const std::vector<double> &legAngles)
+{
+    _nLegs = legAngles.size();
+    int nMovements = getNumMovements();
+    _conflicts.assign(nMovements * nMovements, 0);
+
+    // Each leg is represented by two points on a circle around the intersection: the incoming lane slightly to one side
+    // of the street axis and the outgoing lane slightly to the other (right-hand traffic with the y axis pointing down).
+    // A movement is the chord from the incoming point of its first leg to the outgoing point of its second leg.
+    // Two movements cross if their chords interleave, e.g. a left turn and the opposing straight-through movement,
+    // whereas opposing straight-through movements or two right turns do not.
+    const double laneOffset = 0.01;
+    std::vector<double> inPoint(_nLegs), outPoint(_nLegs);
+    for (int leg = 0; leg < _nLegs; leg++)
+    {
+        inPoint[leg] = normalizeAngle(legAngles[leg] - laneOffset);
+        outPoint[leg] = normalizeAngle(legAngles[leg] + laneOffset);
+    }
+
+    // check whether point p lies on the arc going counter-clockwise from start to end
+    auto isOnArc = [](double p, double start, double end) {
+        return normalizeAngle(p - start) < normalizeAngle(end - start);
+    };
+
+    for (int a = 0; a < nMovements; a++)
+    {
+        int fromA = a / _nLegs, toA = a % _nLegs;
+        for (int b = 0; b < nMovements; b++)
+        {
+            int fromB = b / _nLegs, toB = b % _nLegs;
+            bool isConflicting;
+            if (fromA == fromB)
+            {
+                // vehicles from the same leg are limited by its number of lanes rather than by this matrix
+                isConflicting = false;
+            }
+            else if (toA == toB)
+            {
+                // merging into the same street
+                isConflicting = true;
+            }
+            else
+            {
+                bool isFromBInside = isOnArc(inPoint[fromB], inPoint[fromA], outPoint[toA]);
+                bool isToBInside = isOnArc(outPoint[toB], inPoint[fromA], outPoint[toA]);
+                isConflicting = isFromBInside != isToBInside;
+            }
+            _conflicts[a * nMovements + b] = isConflicting;
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef CONFLICTMATRIX_H
+#define CONFLICTMATRIX_H
+
+#include <vector>
+
+// tells which movements through an intersection may take place at the same time.
+// A movement leads from the leg a vehicle arrives on to the leg it leaves on, legs being the connected streets.
+class ConflictMatrix
+{
+public:
+    // constructor / destructor
+    ConflictMatrix();
+
+    // getters / setters
+    int getNumLegs() const { return _nLegs; }
+    int getNumMovements() const { return _nLegs * _nLegs; }
+    int getMovement(int fromLeg, int toLeg) const { return fromLeg * _nLegs + toLeg; }
+    int getFromLeg(int movement) const { return movement / _nLegs; }
+    bool isConflicting(int movementA, int movementB) const { return _conflicts[movementA * getNumMovements() + movementB]; }
+
+    // typical behaviour methods
+    // build from the angle (atan2 in pixel coordinates) of the direction in which each leg leaves the intersection
+    void build(const std::vector<double> &legAngles);
+
+private:
+    int _nLegs;
+    std::vector<char> _conflicts; // row-major getNumMovements() x getNumMovements() matrix
+};
+
+#endif
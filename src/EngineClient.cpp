@@ -0,0 +1,130 @@
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "EngineProtocol.h"
+#include "EngineClient.h"
+
+/* Implementation of class "EngineClient" */
+
+EngineClient::EngineClient(const std::string &socketPath) : _fd(-1), _shmFd(-1), _segment(nullptr), _segmentSize(0)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("socket path too long: " + socketPath);
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    try
+    {
+        _fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (_fd < 0 || ::connect(_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+            throw systemError("connect to " + socketPath);
+
+        // the server names the segment holding the state arrays as soon as the connection is accepted
+        EngineHello hello;
+        if (!readAll(_fd, &hello, sizeof(hello)) || hello.magic != engineProtocolMagic || hello.version != engineProtocolVersion)
+            throw std::runtime_error("no traffic simulation server of protocol version " + std::to_string(engineProtocolVersion) + " at " + socketPath);
+        hello.shmName[sizeof(hello.shmName) - 1] = '\0';
+        _shmFd = ::shm_open(hello.shmName, O_RDONLY, 0);
+        if (_shmFd < 0)
+            throw systemError(std::string("shm_open ") + hello.shmName);
+
+        // the segment already holds the initial state
+        struct stat status;
+        if (::fstat(_shmFd, &status) < 0)
+            throw systemError(std::string("fstat ") + hello.shmName);
+        mapSegment(status.st_size);
+    }
+    catch (...)
+    {
+        close();
+        throw;
+    }
+}
+
+EngineClient::~EngineClient()
+{
+    close();
+}
+
+void EngineClient::close()
+{
+    if (_segment)
+        ::munmap(const_cast<void *>(_segment), _segmentSize);
+    _segment = nullptr;
+    if (_shmFd >= 0)
+        ::close(_shmFd);
+    _shmFd = -1;
+    if (_fd >= 0)
+        ::close(_fd);
+    _fd = -1;
+}
+
+StateView<VehicleState> EngineClient::getVehicles() const
+{
+    const EngineSegmentHeader *header = static_cast<const EngineSegmentHeader *>(_segment);
+    const char *segment = static_cast<const char *>(_segment);
+    return StateView<VehicleState>(reinterpret_cast<const VehicleState *>(segment + header->vehiclesOffset), header->nVehicles);
+}
+
+StateView<IntersectionState> EngineClient::getIntersections() const
+{
+    const EngineSegmentHeader *header = static_cast<const EngineSegmentHeader *>(_segment);
+    const char *segment = static_cast<const char *>(_segment);
+    return StateView<IntersectionState>(reinterpret_cast<const IntersectionState *>(segment + header->intersectionsOffset), header->nIntersections);
+}
+
+long EngineClient::getStepCount() const
+{
+    return static_cast<const EngineSegmentHeader *>(_segment)->stepCount;
+}
+
+void EngineClient::step(long nSteps, const CommandBuffer &commands)
+{
+    request(requestStep, nSteps, commands);
+}
+
+void EngineClient::quit()
+{
+    request(requestQuit, 0, CommandBuffer());
+}
+
+void EngineClient::request(uint32_t type, long nSteps, const CommandBuffer &commands)
+{
+    // the request and its command batch go out in one write, the reply arrives once the server has published the state
+    std::vector<char> message(sizeof(EngineRequest) + commands.size() * sizeof(Command));
+    EngineRequest request{type, static_cast<uint32_t>(commands.size()), nSteps};
+    std::memcpy(message.data(), &request, sizeof(request));
+    std::memcpy(message.data() + sizeof(request), commands.getCommands().data(), commands.size() * sizeof(Command));
+
+    EngineReply reply;
+    if (!writeAll(_fd, message.data(), message.size()) || !readAll(_fd, &reply, sizeof(reply)))
+        throw std::runtime_error("connection to the traffic simulation server lost");
+    if (reply.status == replyInvalidCommand)
+        throw std::invalid_argument("command batch rejected by the traffic simulation server");
+    if (reply.status != replyOk)
+        throw std::invalid_argument("request rejected by the traffic simulation server");
+
+    // the segment grows when vehicles have been injected
+    if (reply.segmentSize != _segmentSize)
+        mapSegment(reply.segmentSize);
+}
+
+void EngineClient::mapSegment(size_t size)
+{
+    if (_segment)
+        ::munmap(const_cast<void *>(_segment), _segmentSize);
+    _segment = nullptr;
+    void *segment = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, _shmFd, 0);
+    if (segment == MAP_FAILED)
+        throw systemError("mmap traffic simulation state");
+    _segment = segment;
+    _segmentSize = size;
+}
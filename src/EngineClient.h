@@ -0,0 +1,40 @@
+#ifndef ENGINECLIENT_H
+#define ENGINECLIENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "EngineState.h"
+
+// Controller side of EngineServer: sends command batches and step requests over the Unix socket
+// and reads the published state directly from the mapped shared memory segment.
+class EngineClient
+{
+public:
+    // constructor / destructor
+    EngineClient(const std::string &socketPath); // throws std::runtime_error if the server cannot be reached
+    ~EngineClient();
+
+    // getters / setters, the views stay valid until the next call of step()
+    StateView<VehicleState> getVehicles() const;
+    StateView<IntersectionState> getIntersections() const;
+    long getStepCount() const;
+
+    // typical behaviour methods
+    void step(long nSteps, const CommandBuffer &commands = CommandBuffer()); // throws std::invalid_argument if the server rejects the commands
+    void quit();                                                             // shut the server down
+
+private:
+    // typical behaviour methods
+    void request(uint32_t type, long nSteps, const CommandBuffer &commands);
+    void mapSegment(size_t size);
+    void close();
+
+
+    int _fd;
+    int _shmFd;
+    const void *_segment;
+    size_t _segmentSize;
+};
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef ENGINEKERNEL_H
+#define ENGINEKERNEL_H
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "Street.h"
+#include "Intersection.h"
+#include "EngineState.h"
+
+// streets and intersections of a scenario, addressed by their index in the scenario. Built once per scenario
+// (see Scenario::getNetwork()) and only read by engines, so that the processes of a PartitionedSimulation
+// share it copy-on-write instead of each taking its own references to every street and intersection
+struct EngineNetwork
+{
+    const std::vector<std::shared_ptr<Street>> &streets;             // owned by the scenario
+    const std::vector<std::shared_ptr<Intersection>> &intersections;
+    std::vector<int> streetIns, streetOuts;         // index of the 'in' and 'out' intersection of every street
+    std::unordered_map<int, int> streetIndex;       // street id -> index
+    std::unordered_map<int, int> intersectionIndex; // intersection id -> index
+
+    EngineNetwork(const std::vector<std::shared_ptr<Street>> &streets, const std::vector<std::shared_ptr<Intersection>> &intersections)
+        : streets(streets), intersections(intersections)
+    {
+        for (size_t ni = 0; ni < intersections.size(); ni++)
+        {
+            intersectionIndex[intersections[ni]->getID()] = ni;
+        }
+        for (size_t ns = 0; ns < streets.size(); ns++)
+        {
+            streetIndex[streets[ns]->getID()] = ns;
+            streetIns.push_back(getIntersectionIndex(streets[ns]->getInIntersection()));
+            streetOuts.push_back(getIntersectionIndex(streets[ns]->getOutIntersection()));
+        }
+    }
+
+    int getStreetIndex(const std::shared_ptr<Street> &street) const { return streetIndex.at(street->getID()); }
+    int getIntersectionIndex(const std::shared_ptr<Intersection> &intersection) const { return intersectionIndex.at(intersection->getID()); }
+    int getOtherEnd(int street, int intersection) const { return streetIns[street] == intersection ? streetOuts[street] : streetIns[street]; }
+};
+
+// moves the vehicles of SimulationEngine, one virtual call per step for all vehicles in the stepped mode
+// and one per vehicle event in the discrete-event mode
+class EngineKernel
+{
+public:
+    // constructor / destructor
+    virtual ~EngineKernel() {}
+
+    // typical behaviour methods
+    virtual void seedVehicle(size_t vehicle, unsigned int seed) = 0; // (re)create the routing state of a vehicle slot
+    // move all vehicles which are driving or crossing by dt seconds and let those reaching the halting position
+    // choose their next street (status vehicleArrived)
+    virtual void advance(std::vector<VehicleState> &vehicles, double dt) = 0;
+
+    // discrete-event mode
+    virtual void route(std::vector<VehicleState> &vehicles, size_t vehicle) = 0;  // choose the next street at the halting position
+    virtual double getTravelTime(const VehicleState &vehicle, double completion) = 0; // time in s until the vehicle reaches completion
+    virtual void moveBy(VehicleState &vehicle, double time) = 0;                    // advance a driving or crossing vehicle by time s
+};
+
+// kernel compiled for one combination of motion model and routing policy, the stepped counterpart of VehicleModel
+template <typename Motion, typename Routing>
+class EngineKernelModel final : public EngineKernel
+{
+public:
+    // constructor / destructor
+    EngineKernelModel(const EngineNetwork &network) : _network(network) {}
+
+    // typical behaviour methods
+    void seedVehicle(size_t vehicle, unsigned int seed) override;
+    void advance(std::vector<VehicleState> &vehicles, double dt) override;
+    void route(std::vector<VehicleState> &vehicles, size_t vehicle) override { chooseNextStreet(vehicles[vehicle], vehicle); }
+    double getTravelTime(const VehicleState &vehicle, double completion) override;
+    void moveBy(VehicleState &vehicle, double time) override;
+
+private:
+    // typical behaviour methods
+    void chooseNextStreet(VehicleState &vehicle, size_t nv);
+
+    const EngineNetwork &_network;
+    std::vector<Routing> _routings; // routing policy state of every vehicle, in the order of the state array
+};
+
+template <typename Motion, typename Routing>
+void EngineKernelModel<Motion, Routing>::seedVehicle(size_t vehicle, unsigned int seed)
+{
+    // slots of vehicles handed over to another partition are reused
+    if (vehicle < _routings.size())
+        _routings[vehicle] = Routing(seed);
+    else
+        _routings.emplace_back(seed);
+}
+
+template <typename Motion, typename Routing>
+void EngineKernelModel<Motion, Routing>::advance(std::vector<VehicleState> &vehicles, double dt)
+{
+    for (size_t nv = 0; nv < vehicles.size(); nv++)
+    {
+        VehicleState &vehicle = vehicles[nv];
+        if (vehicle.status != vehicleDriving && vehicle.status != vehicleCrossing)
+            continue;
+
+        // update position with the speed given by the motion model, the same way as VehicleModel::drive()
+        const std::shared_ptr<Street> &street = _network.streets[vehicle.street];
+        vehicle.posStreet += Motion::getSpeed(vehicle.speed, vehicle.completion, vehicle.status == vehicleCrossing) * dt;
+        vehicle.completion = vehicle.posStreet / street->getLength();
+        street->getGeometry().getPosition(vehicle.posStreet, vehicle.isForward, vehicle.segment, vehicle.x, vehicle.y);
+
+        // choose the next street at the halting position, the engine queues the vehicle up for this movement
+        if (vehicle.status == vehicleDriving && vehicle.completion >= 0.9)
+            chooseNextStreet(vehicle, nv);
+    }
+}
+
+template <typename Motion, typename Routing>
+void EngineKernelModel<Motion, Routing>::chooseNextStreet(VehicleState &vehicle, size_t nv)
+{
+    const std::shared_ptr<Street> &street = _network.streets[vehicle.street];
+    const std::shared_ptr<Intersection> &destination = _network.intersections[vehicle.destination];
+    std::vector<std::shared_ptr<Street>> streetOptions = destination->queryStreets(street);
+    if (streetOptions.size() > 0)
+        vehicle.nextStreet = _network.getStreetIndex(_routings[nv].chooseNextStreet(streetOptions, street, destination));
+    else
+        vehicle.nextStreet = vehicle.street; // dead-end, drive back the same way
+    vehicle.status = vehicleArrived;
+}
+
+template <typename Motion, typename Routing>
+double EngineKernelModel<Motion, Routing>::getTravelTime(const VehicleState &vehicle, double completion)
+{
+    double length = _network.streets[vehicle.street]->getLength();
+    return Motion::getTravelTime(vehicle.speed, length, vehicle.completion, completion, vehicle.status == vehicleCrossing);
+}
+
+template <typename Motion, typename Routing>
+void EngineKernelModel<Motion, Routing>::moveBy(VehicleState &vehicle, double time)
+{
+    const std::shared_ptr<Street> &street = _network.streets[vehicle.street];
+    vehicle.completion = Motion::getCompletion(vehicle.speed, street->getLength(), vehicle.completion, time, vehicle.status == vehicleCrossing);
+    vehicle.posStreet = vehicle.completion * street->getLength();
+    street->getGeometry().getPosition(vehicle.posStreet, vehicle.isForward, vehicle.segment, vehicle.x, vehicle.y);
+}
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef ENGINEPROTOCOL_H
+#define ENGINEPROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include "EngineState.h"
+
+/*
+ * Messages exchanged between EngineServer and a controller over a local Unix stream socket.
+ * Only requests, command batches and short replies travel over the socket; the state arrays are
+ * published in a POSIX shared memory segment which the controller maps once. Both sides are built
+ * from these sources, so all records are sent in their in-memory layout without serialization.
+ */
+
+static const uint32_t engineProtocolMagic = 0x54524146; // "TRAF"
+static const uint32_t engineProtocolVersion = 2;
+
+// sent by the server right after a controller has connected
+struct EngineHello
+{
+    uint32_t magic;
+    uint32_t version;
+    char shmName[64]; // name of the shared memory segment to pass to shm_open()
+};
+
+enum EngineRequestType : uint32_t
+{
+    requestStep, // apply the attached commands, advance nSteps and publish the state
+    requestQuit, // reply and shut the server down
+};
+
+// followed by nCommands records of type Command
+struct EngineRequest
+{
+    uint32_t type;
+    uint32_t nCommands;
+    int64_t nSteps;
+};
+
+enum EngineReplyStatus : int32_t
+{
+    replyOk,
+    replyInvalidCommand, // the command batch has been rejected as a whole, the engine has not stepped
+    replyInvalidRequest,
+};
+
+struct EngineReply
+{
+    int32_t status;
+    uint32_t reserved;
+    uint64_t segmentSize; // current size of the shared memory segment, remap when it has grown
+    int64_t stepCount;
+};
+
+// start of the shared memory segment, followed by the intersection and the vehicle array at the given offsets
+struct EngineSegmentHeader
+{
+    int64_t stepCount;
+    uint32_t nIntersections;
+    uint32_t nVehicles;
+    uint64_t intersectionsOffset;
+    uint64_t vehiclesOffset;
+};
+
+// read or write exactly size bytes on a socket, return false when the peer has closed the connection
+bool readAll(int fd, void *data, size_t size);
+bool writeAll(int fd, const void *data, size_t size);
+
+// exception describing the failed system call what, including errno
+std::runtime_error systemError(const std::string &what);
+
+#endif
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "SimulationEngine.h"
+#include "EngineProtocol.h"
+#include "EngineServer.h"
+
+// upper bound of the command batch size, protects against a controller speaking another protocol
+static const uint32_t maxCommands = 1 << 20;
+
+/* Implementation of class "EngineServer" */
+
+EngineServer::EngineServer(SimulationEngine &engine, const std::string &socketPath)
+    : _engine(engine), _socketPath(socketPath), _listenFd(-1), _shmFd(-1), _segment(nullptr), _segmentSize(0)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("socket path too long: " + socketPath);
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    try
+    {
+        // one segment per server process, named after its pid
+        _shmName = "/traffic_simulation." + std::to_string(::getpid());
+        _shmFd = ::shm_open(_shmName.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+        if (_shmFd < 0)
+            throw systemError("shm_open " + _shmName);
+        publish();
+
+        ::unlink(socketPath.c_str());
+        _listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (_listenFd < 0 || ::bind(_listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || ::listen(_listenFd, 1) < 0)
+            throw systemError("listen on " + socketPath);
+    }
+    catch (...)
+    {
+        close();
+        throw;
+    }
+}
+
+EngineServer::~EngineServer()
+{
+    close();
+}
+
+void EngineServer::close()
+{
+    if (_listenFd >= 0)
+    {
+        ::close(_listenFd);
+        ::unlink(_socketPath.c_str());
+        _listenFd = -1;
+    }
+    if (_segment)
+    {
+        ::munmap(_segment, _segmentSize);
+        _segment = nullptr;
+    }
+    if (_shmFd >= 0)
+    {
+        ::close(_shmFd);
+        ::shm_unlink(_shmName.c_str());
+        _shmFd = -1;
+    }
+}
+
+void EngineServer::run()
+{
+    while (true)
+    {
+        int fd = ::accept(_listenFd, nullptr, nullptr);
+        if (fd < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw systemError("accept on " + _socketPath);
+        }
+        bool isQuit = serveController(fd);
+        ::close(fd);
+        if (isQuit)
+            return;
+    }
+}
+
+bool EngineServer::serveController(int fd)
+{
+    EngineHello hello{};
+    hello.magic = engineProtocolMagic;
+    hello.version = engineProtocolVersion;
+    std::strncpy(hello.shmName, _shmName.c_str(), sizeof(hello.shmName) - 1);
+    if (!writeAll(fd, &hello, sizeof(hello)))
+        return false;
+
+    std::vector<Command> commands;
+    EngineRequest request;
+    while (readAll(fd, &request, sizeof(request)))
+    {
+        if (request.nCommands > maxCommands)
+            return false;
+        commands.resize(request.nCommands);
+        if (!readAll(fd, commands.data(), commands.size() * sizeof(Command)))
+            return false;
+
+        EngineReply reply{};
+        reply.status = replyOk;
+        if (request.type == requestStep && request.nSteps >= 0)
+        {
+            try
+            {
+                _engine.submit(commands.data(), commands.size());
+                _engine.step(request.nSteps);
+                publish();
+            }
+            catch (const std::out_of_range &)
+            {
+                reply.status = replyInvalidCommand;
+            }
+        }
+        else if (request.type != requestQuit)
+        {
+            reply.status = replyInvalidRequest;
+        }
+        reply.segmentSize = _segmentSize;
+        reply.stepCount = _engine.getStepCount();
+
+        if (!writeAll(fd, &reply, sizeof(reply)))
+            return false;
+        if (request.type == requestQuit)
+            return true;
+    }
+
+    // the controller has disconnected, wait for the next one
+    return false;
+}
+
+void EngineServer::publish()
+{
+    StateView<IntersectionState> intersections = _engine.getIntersections();
+    StateView<VehicleState> vehicles = _engine.getVehicles();
+
+    EngineSegmentHeader header{};
+    header.stepCount = _engine.getStepCount();
+    header.nIntersections = intersections.size();
+    header.nVehicles = vehicles.size();
+    header.intersectionsOffset = sizeof(EngineSegmentHeader);
+    header.vehiclesOffset = header.intersectionsOffset + intersections.size() * sizeof(IntersectionState);
+
+    // injected vehicles let the vehicle array grow, so the segment grows in steps of its doubled size
+    size_t size = header.vehiclesOffset + vehicles.size() * sizeof(VehicleState);
+    if (size > _segmentSize)
+        resizeSegment(std::max(size, 2 * _segmentSize));
+
+    char *segment = static_cast<char *>(_segment);
+    std::memcpy(segment + header.intersectionsOffset, intersections.data(), intersections.size() * sizeof(IntersectionState));
+    std::memcpy(segment + header.vehiclesOffset, vehicles.data(), vehicles.size() * sizeof(VehicleState));
+    std::memcpy(segment, &header, sizeof(header));
+}
+
+void EngineServer::resizeSegment(size_t size)
+{
+    if (_segment)
+        ::munmap(_segment, _segmentSize);
+    _segment = nullptr;
+    if (::ftruncate(_shmFd, size) < 0)
+        throw systemError("ftruncate " + _shmName);
+    _segment = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _shmFd, 0);
+    if (_segment == MAP_FAILED)
+    {
+        _segment = nullptr;
+        throw systemError("mmap " + _shmName);
+    }
+    _segmentSize = size;
+}
@@ -0,0 +1,42 @@
+#ifndef ENGINESERVER_H
+#define ENGINESERVER_H
+
+#include <cstddef>
+#include <string>
+
+// forward declarations to avoid include cycle
+class SimulationEngine;
+
+// Serves a SimulationEngine to an external controller on the same machine (see EngineProtocol.h).
+// Controllers connect one after another to a Unix stream socket; after every step request the state
+// arrays are copied into a shared memory segment, which the controller reads in place.
+class EngineServer
+{
+public:
+    // constructor / destructor
+    EngineServer(SimulationEngine &engine, const std::string &socketPath); // throws std::runtime_error if the socket or segment cannot be created
+    ~EngineServer();
+
+    // getters / setters
+    const std::string &getShmName() const { return _shmName; }
+
+    // typical behaviour methods
+    void run(); // serve controllers until one of them sends requestQuit
+
+private:
+    // typical behaviour methods
+    bool serveController(int fd); // returns true when the controller has asked the server to quit
+    void publish();               // copy the current state into the segment, growing it if necessary
+    void resizeSegment(size_t size);
+    void close();                 // remove the socket and the segment
+
+    SimulationEngine &_engine;
+    std::string _socketPath;
+    std::string _shmName;
+    int _listenFd;
+    int _shmFd;
+    void *_segment;
+    size_t _segmentSize;
+};
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef ENGINESTATE_H
+#define ENGINESTATE_H
+
+#include <cstddef>
+#include <vector>
+#include "TrafficLight.h"
+
+/*
+ * Plain state records of the stepped SimulationEngine and the commands which control it.
+ * All of them are trivially copyable, so they are handed out as views on the engine's arrays
+ * and copied as they are into the shared memory segment of EngineServer.
+ */
+
+enum VehicleStatus
+{
+    vehicleDriving,   // driving towards the halting position in front of its destination
+    vehicleArrived,   // has just reached the halting position and chosen its next street
+    vehicleWaiting,   // waiting in the queue of its movement
+    vehiclePermitted, // part of a platoon, waiting for its slot and for green
+    vehicleCrossing,  // crossing the intersection
+    vehicleInactive,  // handed over to another partition, the slot is reused for the next vehicle
+};
+
+struct VehicleState
+{
+    int id;                 // id of the traffic object
+    VehicleStatus status;
+    int street;             // index of the current street
+    int destination;        // index of the intersection the vehicle is driving to
+    int nextStreet;         // index of the street chosen at the halting position, -1 before
+    bool isForward;         // true when driving from the street's 'in' to its 'out' intersection
+    size_t segment;         // polyline segment of the current street the vehicle was last found on
+    double speed;           // cruising speed in m/s
+    double posStreet;       // position on the current street in m
+    double completion;      // share of the current street driven so far
+    double x, y;            // position in pixels
+    double queuedTime;      // simulated time at which the vehicle queued up in front of its destination in s
+    double releaseTime;     // simulated time from which a permitted vehicle may enter in s
+    double updateTime;      // simulated time of posStreet, x and y in s (lags behind between events in the discrete-event mode)
+};
+
+struct IntersectionState
+{
+    int id;                      // id of the traffic object
+    double x, y;                 // position in pixels
+    TrafficLightPhase phase;
+    bool isExternallyControlled; // phase set by a command instead of the light's own cycle
+    int queueLength;             // number of vehicles waiting in all queues
+    int activeVehicles;          // number of vehicles currently crossing
+    double phaseTime;            // time since the last phase change in s
+    double cycleDuration;        // duration of the current phase in s, 0 while externally controlled
+};
+
+// vehicle leaving the partition which owns its last intersection for the partition owning its destination
+struct VehicleHandoff
+{
+    int id;
+    int street;         // index of the street the vehicle has just turned into
+    int destination;    // index of the intersection at its other end
+    unsigned int seed;  // seed for the routing state in the receiving partition
+    double speed;       // cruising speed in m/s
+    double time;        // simulated time at which the vehicle has entered the street in s
+};
+
+// read-only view on one of the state arrays, valid until the next call of step() or submit()
+template <class T>
+class StateView
+{
+public:
+    // constructor / destructor
+    StateView(const T *data, size_t size) : _data(data), _size(size) {}
+
+    // getters / setters
+    const T *data() const { return _data; }
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    const T &operator[](size_t i) const { return _data[i]; }
+    const T *begin() const { return _data; }
+    const T *end() const { return _data + _size; }
+
+private:
+    const T *_data;
+    size_t _size;
+};
+
+enum CommandType
+{
+    commandSetPhase,      // target = intersection index, value = TrafficLightPhase
+    commandReleasePhase,  // target = intersection index
+    commandInjectVehicle, // target = street index, value = index of the destination intersection, position = m into the street
+};
+
+struct Command
+{
+    CommandType type;
+    int target;
+    int value;
+    double position;
+};
+
+// batch of control actions, applied together at the beginning of the next step
+class CommandBuffer
+{
+public:
+    // getters / setters
+    const std::vector<Command> &getCommands() const { return _commands; }
+    size_t size() const { return _commands.size(); }
+    bool empty() const { return _commands.empty(); }
+
+    // typical behaviour methods
+    void setPhase(int intersection, TrafficLightPhase phase) { _commands.push_back(Command{commandSetPhase, intersection, phase, 0.0}); }    // take over the light
+    void releasePhase(int intersection) { _commands.push_back(Command{commandReleasePhase, intersection, 0, 0.0}); }                        // hand the light back to its own cycle
+    void injectVehicle(int street, int destination, double position = 0.0) { _commands.push_back(Command{commandInjectVehicle, street, destination, position}); }
+    void clear() { _commands.clear(); }
+
+private:
+    std::vector<Command> _commands;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <thread>
+
+#include "Scenario.h"
+#include "SimulationEngine.h"
+#include "Ensemble.h"
+
+Ensemble::Ensemble()
+{
+    // by default run as many scenarios at the same time as there are cores
+    _nWorkers = std::max(1u, std::thread::hardware_concurrency());
+}
+
+void Ensemble::addScenario(const ScenarioConfig &config)
+{
+    _configs.push_back(config);
+}
+
+void Ensemble::run()
+{
+    _results.assign(_configs.size(), SimulationStats());
+
+    // each worker repeatedly picks the next scenario which has not been started yet
+    std::atomic<size_t> nextScenario(0);
+    auto worker = [this, &nextScenario]() {
+        for (size_t i = nextScenario++; i < _configs.size(); i = nextScenario++)
+        {
+            // every scenario owns its traffic objects and context, so nothing is shared between workers
+            const ScenarioConfig &config = _configs.at(i);
+            Scenario scenario(config);
+            if (config.isEventDriven)
+            {
+                // simulate the configured duration as fast as the events can be processed
+                SimulationEngine engine(scenario);
+                engine.step(std::lround(config.duration / SimulationEngine::stepDuration));
+                _results.at(i) = engine.getStats();
+            }
+            else
+            {
+                _results.at(i) = scenario.run();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    int nWorkers = std::min(_nWorkers, static_cast<int>(_configs.size()));
+    for (int nw = 0; nw < nWorkers; nw++)
+    {
+        workers.emplace_back(std::thread(worker));
+    }
+    std::for_each(workers.begin(), workers.end(), [](std::thread &t) {
+        t.join();
+    });
+}
+
+void Ensemble::printReport(std::ostream &os)
+{
+    // merge the statistics of all runs sharing the same parameters
+    std::map<std::string, SimulationStats> merged;
+    SimulationStats total;
+    for (size_t i = 0; i < _results.size(); i++)
+    {
+        merged[_configs.at(i).getLabel()].merge(_results.at(i));
+        total.merge(_results.at(i));
+    }
+
+    auto printStats = [&os](const std::string &label, const SimulationStats &stats) {
+        os << std::left << std::setw(64) << label << std::right << std::fixed << std::setprecision(2)
+           << " runs=" << stats.runs
+           << " crossings=" << stats.crossings
+           << " throughput=" << stats.getThroughput() << " veh/s"
+           << " meanWait=" << stats.getMeanWaitTime() << " ms"
+           << " maxWait=" << stats.maxWaitTime << " ms" << std::endl;
+    };
+
+    os << "Ensemble report (" << _results.size() << " runs, " << _nWorkers << " workers)" << std::endl;
+    for (auto &it : merged)
+    {
+        printStats(it.first, it.second);
+    }
+    printStats("all", total);
+}
@@ -0,0 +1,30 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <ostream>
+#include <vector>
+#include "SimulationContext.h"
+
+// runs many independent scenario instances concurrently within one process, e.g. for parameter sweeps
+class Ensemble
+{
+public:
+    // constructor / destructor
+    Ensemble();
+
+    // getters / setters
+    void setNumWorkers(int nWorkers) { _nWorkers = nWorkers; }
+    const std::vector<SimulationStats> &getResults() { return _results; }
+
+    // typical behaviour methods
+    void addScenario(const ScenarioConfig &config);
+    void run();                         // run all scenarios, at most _nWorkers of them at the same time
+    void printReport(std::ostream &os); // statistics merged per parameter set and over all runs
+
+private:
+    std::vector<ScenarioConfig> _configs;  // one entry per scenario instance
+    std::vector<SimulationStats> _results; // statistics of each instance, in the same order as _configs
+    int _nWorkers;                         // number of scenarios running at the same time
+};
+
+#endif
@@ -0,0 +1,6 @@
+#include "FrameProtocol.h"
+
+std::string getFrameShmName(const std::string &name)
+{
+    return "/traffic_frames." + name;
+}
@@ -0,0 +1,70 @@
+#ifndef FRAMEPROTOCOL_H
+#define FRAMEPROTOCOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+ * Layout of the POSIX shared memory segment through which a simulation publishes the frames drawn by
+ * traffic_viewer. The segment holds a header followed by nSlots slots, each with room for the objects of
+ * one frame. Frame n is written into slot n % nSlots under a sequence lock: the writer marks the slot odd
+ * while copying and even once the frame is complete, so that it never waits for a reader. Readers copy the
+ * latest frame and retry if its slot has been overwritten in the meantime.
+ */
+
+static const uint32_t frameProtocolMagic = 0x46524D45; // "FRME"
+static const uint32_t frameProtocolVersion = 1;
+
+enum FrameObjectType : uint8_t
+{
+    frameVehicle,
+    frameIntersection,
+};
+
+// one traffic object as drawn in a frame
+struct FrameObject
+{
+    float x, y;      // position in pixels of the background image
+    int32_t id;
+    uint8_t type;    // FrameObjectType
+    uint8_t isGreen; // intersections only: traffic light phase
+    uint16_t reserved;
+};
+
+// fills the objects of the next frame
+typedef std::function<void(std::vector<FrameObject> &objects)> FrameProvider;
+
+// start of the segment
+struct FrameRingHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nSlots;
+    uint32_t capacity;        // objects per slot
+    uint64_t slotSize;        // bytes per slot including its FrameSlotHeader
+    uint64_t slotsOffset;     // offset of the first slot
+    int32_t writerPid;        // readers detach when this process has gone
+    uint32_t canvasWidth;     // size of the blank canvas used without a background image
+    uint32_t canvasHeight;
+    char background[256];     // absolute path of the background image, empty for none
+    std::atomic<uint64_t> latest;   // number of the last complete frame, 0 before the first one
+    std::atomic<uint32_t> isClosed; // set when the writer has finished
+};
+
+// start of every slot, followed by capacity FrameObject records
+struct FrameSlotHeader
+{
+    std::atomic<uint64_t> sequence; // 2 * frame number once complete, odd while the slot is written
+    double time;                    // wall-clock time since the first frame in s
+    uint32_t nObjects;
+    uint32_t nDropped;              // objects which did not fit into the slot
+};
+
+// name passed to shm_open() for frames published under name
+std::string getFrameShmName(const std::string &name);
+
+#endif
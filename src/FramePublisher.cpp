@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Intersection.h"
+#include "EngineProtocol.h"
+#include "Profiler.h"
+#include "FramePublisher.h"
+
+// a slot can be rewritten once the writer has gone round the ring, which gives readers nSlots - 1 frames of time
+static const uint32_t nFrameSlots = 4;
+
+/* Implementation of class "FramePublisher" */
+
+FramePublisher::FramePublisher(const std::string &name, size_t capacity)
+    : _shmFd(-1), _segment(nullptr), _segmentSize(0), _header(nullptr), _frameCnt(0), _isRunning(false)
+{
+    if (name.empty() || name.find('/') != std::string::npos)
+        throw std::runtime_error("invalid frame ring name: " + name);
+    _shmName = getFrameShmName(name);
+
+    auto alignUp = [](size_t size) { return (size + 63) / 64 * 64; };
+    size_t headerSize = alignUp(sizeof(FrameRingHeader));
+    size_t slotSize = alignUp(sizeof(FrameSlotHeader) + capacity * sizeof(FrameObject));
+    _segmentSize = headerSize + nFrameSlots * slotSize;
+
+    try
+    {
+        // a segment left behind by a crashed simulation of the same name is replaced, viewers still mapping it detach
+        ::shm_unlink(_shmName.c_str());
+        _shmFd = ::shm_open(_shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (_shmFd < 0)
+            throw systemError("shm_open " + _shmName);
+        if (::ftruncate(_shmFd, _segmentSize) < 0)
+            throw systemError("ftruncate " + _shmName);
+        _segment = ::mmap(nullptr, _segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, _shmFd, 0);
+        if (_segment == MAP_FAILED)
+        {
+            _segment = nullptr;
+            throw systemError("mmap " + _shmName);
+        }
+    }
+    catch (...)
+    {
+        close();
+        throw;
+    }
+
+    char *segment = static_cast<char *>(_segment);
+    _header = new (segment) FrameRingHeader();
+    _header->magic = frameProtocolMagic;
+    _header->version = frameProtocolVersion;
+    _header->nSlots = nFrameSlots;
+    _header->capacity = capacity;
+    _header->slotSize = slotSize;
+    _header->slotsOffset = headerSize;
+    _header->writerPid = ::getpid();
+    _header->canvasWidth = 0;
+    _header->canvasHeight = 0;
+    _header->background[0] = '\0';
+    _header->latest = 0;
+    _header->isClosed = 0;
+    for (uint32_t ns = 0; ns < nFrameSlots; ns++)
+    {
+        FrameSlotHeader *slot = new (segment + headerSize + ns * slotSize) FrameSlotHeader();
+        slot->sequence = 0;
+    }
+    _startTime = std::chrono::steady_clock::now();
+}
+
+FramePublisher::~FramePublisher()
+{
+    stop();
+    close();
+}
+
+void FramePublisher::close()
+{
+    if (_segment)
+    {
+        // viewers which are still attached keep the last frame
+        _header->isClosed.store(1, std::memory_order_release);
+        ::munmap(_segment, _segmentSize);
+        _segment = nullptr;
+    }
+    if (_shmFd >= 0)
+    {
+        ::close(_shmFd);
+        ::shm_unlink(_shmName.c_str());
+        _shmFd = -1;
+    }
+}
+
+void FramePublisher::setBackground(const std::string &filename, int width, int height)
+{
+    // viewers may run in another working directory
+    char path[PATH_MAX];
+    std::string background = !filename.empty() && ::realpath(filename.c_str(), path) ? std::string(path) : filename;
+    std::strncpy(_header->background, background.c_str(), sizeof(_header->background) - 1);
+    _header->background[sizeof(_header->background) - 1] = '\0';
+    _header->canvasWidth = std::max(0, width);
+    _header->canvasHeight = std::max(0, height);
+}
+
+void FramePublisher::publish(const std::vector<FrameObject> &objects)
+{
+    uint64_t frame = ++_frameCnt;
+    char *slot = static_cast<char *>(_segment) + _header->slotsOffset + (frame % _header->nSlots) * _header->slotSize;
+    FrameSlotHeader *slotHeader = reinterpret_cast<FrameSlotHeader *>(slot);
+
+    // odd sequence: readers copying this slot right now will notice that they have to retry
+    slotHeader->sequence.store(2 * frame - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    size_t nObjects = std::min<size_t>(objects.size(), _header->capacity);
+    slotHeader->time = std::chrono::duration<double>(std::chrono::steady_clock::now() - _startTime).count();
+    slotHeader->nObjects = nObjects;
+    slotHeader->nDropped = objects.size() - nObjects;
+    std::memcpy(slot + sizeof(FrameSlotHeader), objects.data(), nObjects * sizeof(FrameObject));
+
+    slotHeader->sequence.store(2 * frame, std::memory_order_release);
+    _header->latest.store(frame, std::memory_order_release);
+}
+
+void FramePublisher::start(FrameProvider provider, int framesPerSecond)
+{
+    stop();
+    _isRunning = true;
+    _thread = std::thread(&FramePublisher::run, this, provider, std::max(1, framesPerSecond));
+}
+
+void FramePublisher::stop()
+{
+    _isRunning = false;
+    if (_thread.joinable())
+        _thread.join();
+}
+
+void FramePublisher::run(FrameProvider provider, int framesPerSecond)
+{
+    Profiler::setThreadName("FramePublisher");
+    const std::chrono::microseconds period(1000000 / framesPerSecond);
+    std::vector<FrameObject> objects;
+    auto nextFrame = std::chrono::steady_clock::now();
+    while (_isRunning)
+    {
+        {
+            PROFILE_ZONE("FramePublisher::publish");
+            provider(objects);
+            publish(objects);
+        }
+
+        // after a frame which took too long, carry on at the same rate instead of catching up with a burst
+        nextFrame = std::max(nextFrame + period, std::chrono::steady_clock::now());
+        std::this_thread::sleep_until(nextFrame);
+    }
+}
+
+void FramePublisher::snapshot(const std::vector<std::shared_ptr<TrafficObject>> &trafficObjects, std::vector<FrameObject> &objects)
+{
+    objects.clear();
+    for (auto &object : trafficObjects)
+    {
+        double posx, posy;
+        object->getPosition(posx, posy);
+        FrameObject frameObject{};
+        frameObject.x = posx;
+        frameObject.y = posy;
+        frameObject.id = object->getID();
+        if (object->getType() == ObjectType::objectIntersection)
+        {
+            frameObject.type = frameIntersection;
+            frameObject.isGreen = std::dynamic_pointer_cast<Intersection>(object)->trafficLightIsGreen();
+        }
+        else if (object->getType() == ObjectType::objectVehicle)
+        {
+            frameObject.type = frameVehicle;
+        }
+        else
+        {
+            continue;
+        }
+        objects.push_back(frameObject);
+    }
+}
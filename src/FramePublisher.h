@@ -0,0 +1,54 @@
+#ifndef FRAMEPUBLISHER_H
+#define FRAMEPUBLISHER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FrameProtocol.h"
+
+// forward declarations to avoid include cycle
+class TrafficObject;
+
+// Writer side of the frame ring (see FrameProtocol.h). Publishes snapshots of the traffic objects into a
+// shared memory segment named after the given name, from which any number of traffic_viewer processes
+// draw them. Viewers only read the segment, so they may attach, detach or crash at any time without
+// affecting the simulation, and a slow viewer simply misses frames instead of holding up the writer.
+class FramePublisher
+{
+public:
+    // constructor / destructor
+    FramePublisher(const std::string &name, size_t capacity); // capacity = objects per frame, throws std::runtime_error
+    ~FramePublisher();
+
+    // getters / setters
+    void setBackground(const std::string &filename, int width, int height); // image shown by viewers, or blank canvas size without one
+    long getFrameCount() const { return _frameCnt; }
+
+    // typical behaviour methods
+    void publish(const std::vector<FrameObject> &objects); // never blocks, objects beyond the capacity are dropped
+    void start(FrameProvider provider, int framesPerSecond = 30); // publish the provided frames from a thread of its own
+    void stop();
+
+    static void snapshot(const std::vector<std::shared_ptr<TrafficObject>> &trafficObjects, std::vector<FrameObject> &objects);
+
+private:
+    // typical behaviour methods
+    void run(FrameProvider provider, int framesPerSecond);
+    void close();
+
+    std::string _shmName;
+    int _shmFd;
+    void *_segment;
+    size_t _segmentSize;
+    FrameRingHeader *_header;
+    std::atomic<long> _frameCnt;
+    std::chrono::steady_clock::time_point _startTime;
+    std::thread _thread;
+    std::atomic<bool> _isRunning;
+};
+
+#endif
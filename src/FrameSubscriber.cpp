@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "EngineProtocol.h"
+#include "FrameSubscriber.h"
+
+/* Implementation of class "FrameSubscriber" */
+
+FrameSubscriber::FrameSubscriber(const std::string &name) : _shmFd(-1), _segment(nullptr), _segmentSize(0), _header(nullptr), _lastFrame(0)
+{
+    std::string shmName = getFrameShmName(name);
+    try
+    {
+        _shmFd = ::shm_open(shmName.c_str(), O_RDONLY, 0);
+        if (_shmFd < 0)
+            throw systemError("shm_open " + shmName);
+        struct stat status;
+        if (::fstat(_shmFd, &status) < 0)
+            throw systemError("fstat " + shmName);
+        _segmentSize = status.st_size;
+        if (_segmentSize < sizeof(FrameRingHeader))
+            throw std::runtime_error("no frame ring of protocol version " + std::to_string(frameProtocolVersion) + " in " + shmName);
+        _segment = ::mmap(nullptr, _segmentSize, PROT_READ, MAP_SHARED, _shmFd, 0);
+        if (_segment == MAP_FAILED)
+        {
+            _segment = nullptr;
+            throw systemError("mmap " + shmName);
+        }
+
+        _header = static_cast<const FrameRingHeader *>(_segment);
+        if (_header->magic != frameProtocolMagic || _header->version != frameProtocolVersion ||
+            _header->slotsOffset + _header->nSlots * _header->slotSize > _segmentSize ||
+            sizeof(FrameSlotHeader) + _header->capacity * sizeof(FrameObject) > _header->slotSize)
+            throw std::runtime_error("no frame ring of protocol version " + std::to_string(frameProtocolVersion) + " in " + shmName);
+    }
+    catch (...)
+    {
+        close();
+        throw;
+    }
+}
+
+FrameSubscriber::~FrameSubscriber()
+{
+    close();
+}
+
+void FrameSubscriber::close()
+{
+    if (_segment)
+        ::munmap(const_cast<void *>(_segment), _segmentSize);
+    _segment = nullptr;
+    if (_shmFd >= 0)
+        ::close(_shmFd);
+    _shmFd = -1;
+}
+
+void FrameSubscriber::getCanvasSize(int &width, int &height) const
+{
+    width = _header->canvasWidth;
+    height = _header->canvasHeight;
+}
+
+bool FrameSubscriber::isClosed() const
+{
+    // a simulation which has crashed cannot set the flag any more
+    return _header->isClosed.load(std::memory_order_acquire) || (::kill(_header->writerPid, 0) < 0 && errno == ESRCH);
+}
+
+bool FrameSubscriber::read(std::vector<FrameObject> &objects)
+{
+    // the writer only overwrites the slot of the latest frame after nSlots - 1 further frames, so retries are rare
+    for (int attempt = 0; attempt < 4; attempt++)
+    {
+        uint64_t frame = _header->latest.load(std::memory_order_acquire);
+        if (frame == 0 || frame == _lastFrame)
+            return false;
+
+        const char *slot = static_cast<const char *>(_segment) + _header->slotsOffset + (frame % _header->nSlots) * _header->slotSize;
+        const FrameSlotHeader *slotHeader = reinterpret_cast<const FrameSlotHeader *>(slot);
+        uint64_t sequence = slotHeader->sequence.load(std::memory_order_acquire);
+        if (sequence != 2 * frame)
+            continue;
+
+        size_t nObjects = std::min<size_t>(slotHeader->nObjects, _header->capacity);
+        _buffer.resize(nObjects);
+        std::memcpy(_buffer.data(), slot + sizeof(FrameSlotHeader), nObjects * sizeof(FrameObject));
+
+        // the copy is only valid if the writer has not started on the slot again in the meantime
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slotHeader->sequence.load(std::memory_order_relaxed) == sequence)
+        {
+            _lastFrame = frame;
+            objects.swap(_buffer);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,39 @@
+#ifndef FRAMESUBSCRIBER_H
+#define FRAMESUBSCRIBER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FrameProtocol.h"
+
+// Reader side of the frame ring (see FrameProtocol.h), used by traffic_viewer. Maps the segment read-only,
+// so that nothing a viewer does can disturb the simulation publishing into it.
+class FrameSubscriber
+{
+public:
+    // constructor / destructor
+    FrameSubscriber(const std::string &name); // throws std::runtime_error if no frames are published under name
+    ~FrameSubscriber();
+
+    // getters / setters
+    std::string getBackground() const { return _header->background; }
+    void getCanvasSize(int &width, int &height) const;
+    bool isClosed() const; // the simulation has finished or is gone, no further frames will come
+
+    // typical behaviour methods
+    bool read(std::vector<FrameObject> &objects); // copy the latest frame, false leaves objects unchanged if there is no newer one
+
+private:
+    // typical behaviour methods
+    void close();
+
+    int _shmFd;
+    const void *_segment;
+    size_t _segmentSize;
+    const FrameRingHeader *_header;
+    uint64_t _lastFrame;
+    std::vector<FrameObject> _buffer; // copy which may turn out to be torn
+};
+
+#endif
@@ -1,60 +1,85 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
 #include "Graphics.h"
-#include "Intersection.h"
+#include "FramePublisher.h"
+#include "Profiler.h"
+
+Graphics::Graphics() : _canvasSize(4000, 4000), _windowName("Concurrency Traffic Simulation"), _isBgLoaded(false), _renderMode(renderObjects), _cellSize(8), _gridRows(0), _gridCols(0)
+{
+}
 
 void Graphics::simulate()
 {
-    this->loadBackgroundImg();
+    Profiler::setThreadName("Graphics");
+
+    // create window
+    cv::namedWindow(_windowName, cv::WINDOW_NORMAL);
     while (true)
     {
         // sleep at every iteration to reduce CPU usage
         std::this_thread::sleep_for(std::chrono::milliseconds(1));
 
-        // update graphics
-        this->drawTrafficObjects();
+        // update graphics, leave the loop when ESC has been pressed
+        this->collectFrame();
+        if (!_isBgLoaded)
+            this->loadBackgroundImg();
+        int key = _renderMode == renderDensity ? this->drawDensity() : this->drawTrafficObjects();
+        if (key == 27)
+            return;
     }
 }
 
 void Graphics::loadBackgroundImg()
 {
-    // create window
-    _windowName = "Concurrency Traffic Simulation";
-    cv::namedWindow(_windowName, cv::WINDOW_NORMAL);
-
     // load image and create copy to be used for semi-transparent overlay
-    cv::Mat background = cv::imread(_bgFilename);
+    cv::Mat background = _bgFilename.empty() ? cv::Mat(_canvasSize, CV_8UC3, cv::Scalar(255, 255, 255)) : cv::imread(_bgFilename);
+    _images.clear();
     _images.push_back(background);         // first element is the original background
     _images.push_back(background.clone()); // second element will be the transparent overlay
     _images.push_back(background.clone()); // third element will be the result image for display
+
+    // one density cell per _cellSize x _cellSize pixels
+    _gridCols = (background.cols + _cellSize - 1) / _cellSize;
+    _gridRows = (background.rows + _cellSize - 1) / _cellSize;
+    _density = cv::Mat(_gridRows, _gridCols, CV_32F);
+    _isBgLoaded = true;
 }
 
-void Graphics::drawTrafficObjects()
+void Graphics::collectFrame()
 {
+    PROFILE_ZONE("Graphics::collectFrame");
+    if (_frameProvider)
+        _frameProvider(_frame);
+    else
+        FramePublisher::snapshot(_trafficObjects, _frame);
+}
+
+int Graphics::drawTrafficObjects()
+{
+    PROFILE_ZONE("Graphics::drawTrafficObjects");
+
     // reset images
     _images.at(1) = _images.at(0).clone();
     _images.at(2) = _images.at(0).clone();
 
-    // create overlay from all traffic objects
-    for (auto it : _trafficObjects)
+    // create overlay from all traffic objects of the frame
+    for (auto &it : _frame)
     {
-        double posx, posy;
-        it->getPosition(posx, posy);
+        double posx = it.x, posy = it.y;
 
-        if (it->getType() == ObjectType::objectIntersection)
+        if (it.type == frameIntersection)
         {
-            // cast object type from TrafficObject to Intersection
-            std::shared_ptr<Intersection> intersection = std::dynamic_pointer_cast<Intersection>(it);
-
             // set color according to traffic light and draw the intersection as a circle
-            cv::Scalar trafficLightColor = intersection->trafficLightIsGreen() == true ? cv::Scalar(0, 255, 0) : cv::Scalar(0, 0, 255);
+            cv::Scalar trafficLightColor = it.isGreen ? cv::Scalar(0, 255, 0) : cv::Scalar(0, 0, 255);
             cv::circle(_images.at(1), cv::Point2d(posx, posy), 25, trafficLightColor, -1);
         }
-        else if (it->getType() == ObjectType::objectVehicle)
+        else if (it.type == frameVehicle)
         {
-            cv::RNG rng(it->getID());
+            cv::RNG rng(it.id);
             int b = rng.uniform(0, 255);
             int g = rng.uniform(0, 255);
             int r = sqrt(255*255 - g*g - r*r); // ensure that length of color vector is always 255
@@ -66,7 +91,131 @@ void Graphics::drawTrafficObjects()
     float opacity = 0.85;
     cv::addWeighted(_images.at(1), opacity, _images.at(0), 1.0 - opacity, 0, _images.at(2));
 
+    return display();
+}
+
+int Graphics::drawDensity()
+{
+    PROFILE_ZONE("Graphics::drawDensity");
+
+    // collect the positions of all vehicles
+    _xs.clear();
+    _ys.clear();
+    for (auto &object : _frame)
+    {
+        if (object.type != frameVehicle)
+            continue;
+        _xs.push_back(object.x);
+        _ys.push_back(object.y);
+    }
+    accumulateDensity();
+
+    // colormap the whole grid at once
+    double maxDensity = 0.0;
+    cv::minMaxLoc(_density, nullptr, &maxDensity);
+    cv::Mat density8u;
+    _density.convertTo(density8u, CV_8U, maxDensity > 0.0 ? 255.0 / maxDensity : 0.0);
+    cv::Mat heat;
+    cv::applyColorMap(density8u, heat, cv::COLORMAP_INFERNO);
+    cv::resize(heat, _heat, _images.at(0).size(), 0, 0, cv::INTER_LINEAR);
+
+    // blend it over the map only where there are vehicles, adding it everywhere would saturate bright backgrounds
+    // such as the blank canvas of generated networks to white
+    cv::Mat isOccupied;
+    cv::compare(_density, 0.0, isOccupied, cv::CMP_GT);
+    cv::resize(isOccupied, _heatMask, _images.at(0).size(), 0, 0, cv::INTER_NEAREST);
+    float opacity = 0.85;
+    cv::addWeighted(_images.at(0), 1.0 - opacity, _heat, opacity, 0, _images.at(1));
+    _images.at(0).copyTo(_images.at(2));
+    _images.at(1).copyTo(_images.at(2), _heatMask);
+    drawIntersections(_images.at(2));
+    return display();
+}
+
+void Graphics::accumulateDensity()
+{
+    PROFILE_ZONE("Graphics::accumulateDensity");
+
+    // cell index of every vehicle, branch-free so that the compiler can vectorize the loop
+    size_t nVehicles = std::min(_xs.size(), _ys.size());
+    _cells.resize(nVehicles);
+    const float *xs = _xs.data();
+    const float *ys = _ys.data();
+    int *cells = _cells.data();
+    const float scale = 1.0f / _cellSize;
+    const int cols = _gridCols, rows = _gridRows, outside = _gridRows * _gridCols;
+    const float colsLimit = cols, rowsLimit = rows;
+    const float maxCol = cols - 1, maxRow = rows - 1;
+    for (size_t i = 0; i < nVehicles; i++)
+    {
+        float fx = xs[i] * scale, fy = ys[i] * scale;
+        bool isInside = (fx >= 0.0f) & (fy >= 0.0f) & (fx < colsLimit) & (fy < rowsLimit); // no short-circuit branches, false for NaN
+        // clamp before converting, an out-of-range or NaN float is undefined as int; std::max(0.0f, NaN) is 0
+        int cell = static_cast<int>(std::min(std::max(0.0f, fy), maxRow)) * cols + static_cast<int>(std::min(std::max(0.0f, fx), maxCol));
+        cells[i] = isInside ? cell : outside;
+    }
+
+    // scatter-add every chunk of vehicles into a grid of its own, small fleets are not worth splitting
+    const size_t minChunk = 1 << 16;
+    int nChunks = static_cast<int>(std::max<size_t>(1, std::min<size_t>(std::max(1, cv::getNumThreads()), nVehicles / minChunk)));
+    if (_threadGrids.size() < static_cast<size_t>(nChunks))
+        _threadGrids.resize(nChunks);
+    cv::parallel_for_(cv::Range(0, nChunks), [this, cells, nVehicles, nChunks, outside](const cv::Range &range) {
+        for (int nc = range.start; nc < range.end; nc++)
+        {
+            std::vector<uint32_t> &grid = _threadGrids[nc];
+            grid.assign(outside + 1, 0);
+            size_t begin = nVehicles * nc / nChunks, end = nVehicles * (nc + 1) / nChunks;
+            for (size_t i = begin; i < end; i++)
+            {
+                grid[cells[i]]++;
+            }
+        }
+    });
+
+    // sum up the chunk grids in bands of rows, which no two threads share
+    cv::parallel_for_(cv::Range(0, rows), [this, cols, nChunks](const cv::Range &range) {
+        for (int row = range.start; row < range.end; row++)
+        {
+            float *density = _density.ptr<float>(row);
+            const uint32_t *first = _threadGrids[0].data() + row * cols;
+            for (int col = 0; col < cols; col++)
+            {
+                density[col] = static_cast<float>(first[col]);
+            }
+            for (int nc = 1; nc < nChunks; nc++)
+            {
+                const uint32_t *grid = _threadGrids[nc].data() + row * cols;
+                for (int col = 0; col < cols; col++)
+                {
+                    density[col] += static_cast<float>(grid[col]);
+                }
+            }
+
+            // logarithmic scale, so that a few crowded cells do not hide everything else
+            for (int col = 0; col < cols; col++)
+            {
+                density[col] = std::log1p(density[col]);
+            }
+        }
+    });
+}
+
+void Graphics::drawIntersections(cv::Mat &image)
+{
+    for (auto &object : _frame)
+    {
+        if (object.type != frameIntersection)
+            continue;
+        cv::Scalar trafficLightColor = object.isGreen ? cv::Scalar(0, 255, 0) : cv::Scalar(0, 0, 255);
+        cv::circle(image, cv::Point2d(object.x, object.y), 25, trafficLightColor, -1);
+    }
+}
+
+int Graphics::display()
+{
     // display background and overlay image
+    PROFILE_ZONE("Graphics::display");
     cv::imshow(_windowName, _images.at(2));
-    cv::waitKey(33);
+    return cv::waitKey(33);
 }
@@ -1,33 +1,68 @@
 #ifndef GRAPHICS_H
 #define GRAPHICS_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <opencv2/core.hpp>
 #include "TrafficObject.h"
+#include "FrameProtocol.h"
+
+enum RenderMode
+{
+    renderObjects, // one circle per vehicle
+    renderDensity, // heatmap of the number of vehicles per grid cell
+};
 
 class Graphics
 {
 public:
     // constructor / desctructor
+    Graphics();
 
     // getters / setters
-    void setBgFilename(std::string filename) { _bgFilename = filename; }
+    // the background is reloaded before the next frame, so a frame provider may switch to another map while simulate() runs
+    void setBgFilename(std::string filename) { _bgFilename = filename; _isBgLoaded = false; }
+    void setCanvasSize(int width, int height) { _canvasSize = cv::Size(width, height); _isBgLoaded = false; } // blank background used without an image
     void setTrafficObjects(std::vector<std::shared_ptr<TrafficObject>> &trafficObjects) { _trafficObjects = trafficObjects; };
+    void setRenderMode(RenderMode mode) { _renderMode = mode; }
+    void setFrameProvider(FrameProvider provider) { _frameProvider = provider; } // default: snapshot of the traffic objects
+    void setCellSize(int cellSize) { _cellSize = cellSize; }                      // edge of a density cell in pixels
+    void setWindowName(std::string windowName) { _windowName = windowName; }
 
     // typical behaviour methods
-    void simulate();
+    void simulate(); // runs until ESC is pressed
 
 private:
     // typical behaviour methods
     void loadBackgroundImg();
-    void drawTrafficObjects();
+    void collectFrame();
+    int drawTrafficObjects(); // returns the key pressed while displaying, -1 if none
+    int drawDensity();
+    void accumulateDensity();
+    void drawIntersections(cv::Mat &image);
+    int display();
 
     // member variables
     std::vector<std::shared_ptr<TrafficObject>> _trafficObjects;
     std::string _bgFilename;
+    cv::Size _canvasSize;
     std::string _windowName;
     std::vector<cv::Mat> _images;
+    bool _isBgLoaded; // _images show the current background
+    FrameProvider _frameProvider;
+    std::vector<FrameObject> _frame; // objects drawn in the current frame
+
+    // density mode
+    RenderMode _renderMode;
+    int _cellSize;
+    int _gridRows, _gridCols;
+    std::vector<float> _xs, _ys;                     // vehicle positions of the current frame
+    std::vector<int> _cells;                         // grid cell of every vehicle, vehicles off the map go to an extra cell
+    std::vector<std::vector<uint32_t>> _threadGrids; // vehicle counts of every chunk of vehicles, summed up afterwards
+    cv::Mat _density;                                // log(1 + vehicles) per cell
+    cv::Mat _heat;                                   // colormapped density in the size of the background
+    cv::Mat _heatMask;                               // pixels of the cells holding vehicles
 };
 
-#endif
\ No newline at end of file
+#endif
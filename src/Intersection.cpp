@@ -3,53 +3,133 @@
 #include <chrono>
 #include <future>
 #include <random>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
 
 #include "Street.h"
 #include "Intersection.h"
 #include "Vehicle.h"
+#include "Profiler.h"
 
 /* Implementation of class "WaitingVehicles" */
 
+std::unique_lock<std::mutex> WaitingVehicles::acquireLock()
+{
+    // time spent here is the contention between vehicle threads and the queue processing thread
+    PROFILE_ZONE("WaitingVehicles::lock");
+    return std::unique_lock<std::mutex>(_mutex);
+}
+
 int WaitingVehicles::getSize()
 {
+    // polled every millisecond, so not profiled to keep traces readable
     std::lock_guard<std::mutex> lock(_mutex);
 
-    return _vehicles.size();
+    return _queues.getSize();
 }
 
-void WaitingVehicles::pushBack(std::shared_ptr<Vehicle> vehicle, std::promise<void> &&promise)
+void WaitingVehicles::setLayout(const ConflictMatrix &conflicts, const std::vector<int> &lanes)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    std::unique_lock<std::mutex> lock = acquireLock();
 
-    _vehicles.push_back(vehicle);
-    _promises.push_back(std::move(promise));
+    _queues.setLayout(conflicts, lanes);
 }
 
-void WaitingVehicles::permitEntryToFirstInQueue()
+void WaitingVehicles::pushBack(std::shared_ptr<Vehicle> vehicle, int fromLeg, int toLeg, std::promise<void> &&promise)
+{
+    std::unique_lock<std::mutex> lock = acquireLock();
+
+    // nobody will process the queue anymore, so let the vehicle pass right away
+    if (_isClosed)
+    {
+        promise.set_value();
+        return;
+    }
+
+    _queues.push(vehicle->getID(), std::move(promise), fromLeg, toLeg);
+}
+
+int WaitingVehicles::dischargePlatoons(int platoonSize, std::chrono::milliseconds headway, bool isGreen)
 {
     // Implements part of the message exchange between threads
-    // Sets the promise as 'ready'  
+    // Collects the next platoon of every approach under a single lock, then sets the promises of its vehicles
+    // as 'ready' one after another at saturation flow without holding the lock. The calls in between never block,
+    // so a red light stops the discharge right away and the rest of the platoon waits for the next green
 
-    std::lock_guard<std::mutex> lock(_mutex);
+    auto now = std::chrono::steady_clock::now();
+    if (!isGreen)
+    {
+        _isPlatoonHeld = _nextPermitted < _platoon.size();
+        return 0;
+    }
+
+    if (_nextPermitted < _platoon.size())
+    {
+        // after a red light the platoon starts again from standstill, one headway apart
+        if (_isPlatoonHeld)
+            _platoonStart = now - _platoon[_nextPermitted].slot * headway;
+        _isPlatoonHeld = false;
+    }
+    else
+    {
+        // polled every millisecond, so only the collection of a platoon is profiled
+        if (getSize() == 0)
+            return 0;
+
+        PROFILE_ZONE("WaitingVehicles::collectPlatoons");
+        _platoon.clear();
+        _nextPermitted = 0;
+        std::unique_lock<std::mutex> lock = acquireLock();
+        _queues.popPlatoons(platoonSize, [this](std::promise<void> &&promise, int slot) {
+            _platoon.push_back(PermittedVehicle{std::move(promise), slot});
+        });
+        lock.unlock();
+
+        // fulfill the promises in the order in which the vehicles follow each other
+        std::stable_sort(_platoon.begin(), _platoon.end(), [](const PermittedVehicle &a, const PermittedVehicle &b) {
+            return a.slot < b.slot;
+        });
+        _platoonStart = now;
+    }
 
-    // get entries from the front of both queues
-    auto firstPromise = _promises.begin();
-    auto firstVehicle = _vehicles.begin();
+    int nPermitted = 0;
+    for (; _nextPermitted < _platoon.size() && _platoonStart + _platoon[_nextPermitted].slot * headway <= now; _nextPermitted++)
+    {
+        _platoon[_nextPermitted].promise.set_value();
+        nPermitted++;
+    }
 
-    // fulfill promise and sets the promise as 'ready' (true), indicating that permission to enter has been granted
-    firstPromise->set_value();
+    return nPermitted;
+}
 
-    // remove front elements from both queues
-    _vehicles.erase(firstVehicle);
-    _promises.erase(firstPromise);
+void WaitingVehicles::vehicleHasLeft(int vehicleID)
+{
+    std::unique_lock<std::mutex> lock = acquireLock();
+
+    _queues.release(vehicleID);
+}
+
+void WaitingVehicles::close()
+{
+    std::unique_lock<std::mutex> lock = acquireLock();
+
+    // fulfill all outstanding promises so that no vehicle thread stays blocked
+    _queues.popAll([](std::promise<void> &&promise, int) {
+        promise.set_value();
+    });
+    for (; _nextPermitted < _platoon.size(); _nextPermitted++)
+    {
+        _platoon[_nextPermitted].promise.set_value();
+    }
+    _isClosed = true;
 }
 
 /* Implementation of class "Intersection" */
 
-Intersection::Intersection()
+Intersection::Intersection(std::shared_ptr<SimulationContext> context) : TrafficObject(context), _trafficLight(context)
 {
     _type = ObjectType::objectIntersection;
-    _isBlocked = false;
 }
 
 void Intersection::addStreet(std::shared_ptr<Street> street)
@@ -72,57 +152,117 @@ std::vector<std::shared_ptr<Street>> Intersection::queryStreets(std::shared_ptr<
     return outgoings;
 }
 
+int Intersection::getLeg(std::shared_ptr<Street> street)
+{
+    for (size_t leg = 0; leg < _streets.size(); leg++)
+    {
+        if (_streets[leg]->getID() == street->getID())
+            return leg;
+    }
+    return -1;
+}
+
+void Intersection::getLayout(ConflictMatrix &conflicts, std::vector<int> &lanes)
+{
+    // the direction in which each street leaves the intersection determines which movements cross each other
+    std::vector<double> legAngles;
+    lanes.clear();
+    for (auto &street : _streets)
+    {
+        double dx, dy;
+        bool isForward = street->getInIntersection()->getID() == _id;
+        street->getGeometry().getStartDirection(isForward, dx, dy);
+        legAngles.push_back(std::atan2(dy, dx));
+        lanes.push_back(street->getLanes());
+    }
+
+    conflicts.build(legAngles);
+}
+
+void Intersection::updateLayout()
+{
+    ConflictMatrix conflicts;
+    std::vector<int> lanes;
+    getLayout(conflicts, lanes);
+    _waitingVehicles.setLayout(conflicts, lanes);
+}
+
 // adds a new vehicle to the queue and returns once the vehicle is allowed to enter
-void Intersection::addVehicleToQueue(std::shared_ptr<Vehicle> vehicle)
+void Intersection::addVehicleToQueue(std::shared_ptr<Vehicle> vehicle, std::shared_ptr<Street> incoming, std::shared_ptr<Street> outgoing)
 {
     // method that grants permission to vehicle to enter an intersection
     // blocks the execution of Vehicle::drive() until the traffic light turns green
 
+    // measure how long the vehicle is held up at this intersection
+    auto waitStart = std::chrono::system_clock::now();
+
     // protect cout with mutex shared by all traffic objects
-    std::unique_lock<std::mutex> lck(_mtx);
-    std::cout << "Intersection #" << _id << "::addVehicleToQueue: thread id = " << std::this_thread::get_id() << std::endl;
-    lck.unlock();
+    std::unique_lock<std::mutex> lck(_context->getCoutMutex(), std::defer_lock);
+    if (_context->isVerbose())
+    {
+        lck.lock();
+        std::cout << "Intersection #" << _id << "::addVehicleToQueue: thread id = " << std::this_thread::get_id() << std::endl;
+        lck.unlock();
+    }
 
     /* implement information exchange with vehicle queue (which run in a separate thread) */
 
+    // a movement over a street which is not connected here has no queue, so the vehicle would never be released;
+    // the future returned by std::async rethrows the exception in the drive loop, which takes the vehicle off the road
+    int fromLeg = getLeg(incoming), toLeg = getLeg(outgoing);
+    if (fromLeg < 0 || toLeg < 0)
+        throw std::logic_error("vehicle #" + std::to_string(vehicle->getID()) + " uses a street which is not connected to intersection #" + std::to_string(_id));
+
     // init objects required to add vehicle the waiting line
     // init promise object required to have an object to which to provide a result to
     std::promise<void> prmsVehicleAllowedToEnter;
     // init future object required to read results of promise
     std::future<void> ftrVehicleAllowedToEnter = prmsVehicleAllowedToEnter.get_future();
     // add new vehicle and promise to the end of the _vehicles and _promises vectors part of the WaitingVehicles class
-    // WaitingVehicles::permitEntryToFirstInQueue() later erases the here added vehicle and promise from those vectors
-    _waitingVehicles.pushBack(vehicle, std::move(prmsVehicleAllowedToEnter));
+    // WaitingVehicles::dischargePlatoons() later erases the here added vehicle and promise from the queue
+    // the vehicle queues up for the movement from its current to its next street
+    _waitingVehicles.pushBack(vehicle, fromLeg, toLeg, std::move(prmsVehicleAllowedToEnter));
 
-    // pause the execution until the future is set as 'ready' (true) by WaitingVehicles::permitEntryToFirstInQueue()
-    ftrVehicleAllowedToEnter.wait();
-    lck.lock();
-    std::cout << "Intersection #" << _id << ": Vehicle #" << vehicle->getID() << " is granted entry." << std::endl;
-    lck.unlock();
+    // pause the execution until the future is set as 'ready' (true) by WaitingVehicles::dischargePlatoons()
+    {
+        PROFILE_ZONE("Intersection::waitForEntry");
+        ftrVehicleAllowedToEnter.wait();
+    }
+    if (_context->isVerbose())
+    {
+        lck.lock();
+        std::cout << "Intersection #" << _id << ": Vehicle #" << vehicle->getID() << " is granted entry." << std::endl;
+        lck.unlock();
+    }
 
     // pause the execution of Vehicle::drive() until traffic light turns green (stop vehicle entry when light is red)
      while(_trafficLight.getCurrentPhase() == TrafficLightPhase::red) {
+        PROFILE_ZONE("Intersection::waitForGreen");
         _trafficLight.waitForGreen();
     }
+
+    // vehicles released because the scenario shuts down have not really been granted entry
+    if (_context->isRunning())
+    {
+        double waitTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now() - waitStart).count() / 1000.0;
+        _context->recordCrossing(waitTime);
+    }
 }
 
 void Intersection::vehicleHasLeft(std::shared_ptr<Vehicle> vehicle)
 {
     //std::cout << "Intersection #" << _id << ": Vehicle #" << vehicle->getID() << " has left." << std::endl;
 
-    // unblock queue processing
-    this->setIsBlocked(false);
-}
-
-void Intersection::setIsBlocked(bool isBlocked)
-{
-    _isBlocked = isBlocked;
-    //std::cout << "Intersection #" << _id << " isBlocked=" << isBlocked << std::endl;
+    // release the movement of this vehicle so that conflicting movements may proceed
+    _waitingVehicles.vehicleHasLeft(vehicle->getID());
 }
 
 // virtual function which is executed in a thread
 void Intersection::simulate() // using threads + promises/futures + exceptions
 {
+    // all streets are connected by now, so the conflicts between movements can be determined
+    updateLayout();
+
     // start the simulation of _trafficLight object
     // which toggles the current phase of the traffic light between red and green
     _trafficLight.simulate();
@@ -131,27 +271,36 @@ void Intersection::simulate() // using threads + promises/futures + exceptions
     threads.emplace_back(std::thread(&Intersection::processVehicleQueue, this));
 }
 
+void Intersection::joinThreads()
+{
+    // the traffic light runs its own thread which has to finish before the light is destroyed
+    _trafficLight.joinThreads();
+    TrafficObject::joinThreads();
+}
+
 void Intersection::processVehicleQueue()
 {
     // print id of the current thread
     //std::cout << "Intersection #" << _id << "::processVehicleQueue: thread id = " << std::this_thread::get_id() << std::endl;
+    Profiler::setThreadName("Intersection #" + std::to_string(_id));
+
+    // platoons are released at saturation flow, i.e. with a fixed headway between consecutive vehicles
+    const int platoonSize = _context->getConfig().platoonSize;
+    const std::chrono::milliseconds headway(_context->getConfig().saturationHeadway);
 
-    // continuously process the vehicle queue
-    while (true)
+    // continuously process the vehicle queue until the scenario shuts down
+    while (_context->isRunning())
     {
         // sleep at every iteration to reduce CPU usage
         std::this_thread::sleep_for(std::chrono::milliseconds(1));
 
-        // only proceed when at least one vehicle is waiting in the queue
-        if (_waitingVehicles.getSize() > 0 && !_isBlocked)
-        {
-            // set intersection to "blocked" to prevent other vehicles from entering
-            this->setIsBlocked(true);
-
-            // permit entry to first vehicle in the queue (FIFO)
-            _waitingVehicles.permitEntryToFirstInQueue();
-        }
+        // at green, release the vehicles of the current platoon whose slot has come, or discharge a new platoon
+        // from every approach whose movements do not conflict with the movements in progress
+        _waitingVehicles.dischargePlatoons(platoonSize, headway, trafficLightIsGreen());
     }
+
+    // release all vehicles still waiting so that their threads can finish
+    _waitingVehicles.close();
 }
 
 bool Intersection::trafficLightIsGreen()
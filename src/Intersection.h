@@ -2,59 +2,86 @@
 #define INTERSECTION_H
 
 #include <vector>
+#include <chrono>
 #include <future>
 #include <mutex>
 #include <memory>
 #include "TrafficObject.h"
 #include "TrafficLight.h"
+#include "ConflictMatrix.h"
+#include "MovementQueues.h"
 
 // forward declarations to avoid include cycle
 class Street;
 class Vehicle;
 
-// auxiliary class to queue and dequeue waiting vehicles in a thread-safe manner
+// auxiliary class to queue and dequeue waiting vehicles in a thread-safe manner.
+// There is one queue per movement, i.e. per pair of approach and exit street, so that vehicles
+// heading for a free movement are not held up behind vehicles waiting for a conflicting one.
+// At green, vehicles are discharged in platoons, taking the lock once per platoon. The vehicles of a platoon
+// are released one headway apart by later calls, which hold the rest of the platoon while the light is red.
 class WaitingVehicles
 {
 public:
     // getters / setters
     int getSize();
+    void setLayout(const ConflictMatrix &conflicts, const std::vector<int> &lanes); // lanes = number of lanes per approach
 
     // typical behaviour methods
-    void pushBack(std::shared_ptr<Vehicle> vehicle, std::promise<void> &&promise);
-    void permitEntryToFirstInQueue();
+    void pushBack(std::shared_ptr<Vehicle> vehicle, int fromLeg, int toLeg, std::promise<void> &&promise);
+    int dischargePlatoons(int platoonSize, std::chrono::milliseconds headway, bool isGreen); // release the vehicles of the current platoon whose slot has come, or collect the next platoon of every approach whose movements are free
+    void vehicleHasLeft(int vehicleID);
+    void close(); // permit entry to all waiting vehicles and to every vehicle arriving later on, called by the queue processing thread
 
 private:
-    std::vector<std::shared_ptr<Vehicle>> _vehicles; // list of all vehicles waiting to enter this intersection
-    std::vector<std::promise<void>> _promises; // list of associated promises
+    struct PermittedVehicle
+    {
+        std::promise<void> promise;
+        int slot; // position within the platoon of its approach, counted per lane
+    };
+
+    std::unique_lock<std::mutex> acquireLock();
+
+    MovementQueues<std::promise<void>> _queues; // promises of the waiting vehicles, one queue per movement
     std::mutex _mutex;
+    bool _isClosed = false; // set once the intersection has stopped processing its queue
+
+    // platoon being discharged, only used by the queue processing thread
+    std::vector<PermittedVehicle> _platoon;                     // sorted by slot
+    size_t _nextPermitted = 0;                                  // first vehicle of _platoon still waiting for its slot
+    std::chrono::steady_clock::time_point _platoonStart;        // time of slot 0
+    bool _isPlatoonHeld = false;                                // the light has turned red during the discharge
 };
 
 class Intersection : public TrafficObject
 {
 public:
     // constructor / destructor
-    Intersection();
-
-    // getters / setters
-    void setIsBlocked(bool isBlocked);
+    Intersection(std::shared_ptr<SimulationContext> context);
 
     // typical behaviour methods
-    void addVehicleToQueue(std::shared_ptr<Vehicle> vehicle);
+    void addVehicleToQueue(std::shared_ptr<Vehicle> vehicle, std::shared_ptr<Street> incoming, std::shared_ptr<Street> outgoing); // throws std::logic_error if a street is not connected here
     void addStreet(std::shared_ptr<Street> street);
     std::vector<std::shared_ptr<Street>> queryStreets(std::shared_ptr<Street> incoming); // return pointer to current list of all outgoing streets
     void simulate();
+    void joinThreads();
     void vehicleHasLeft(std::shared_ptr<Vehicle> vehicle);
     bool trafficLightIsGreen();
 
+    // getters / setters
+    const std::vector<std::shared_ptr<Street>> &getStreets() { return _streets; }
+    void getLayout(ConflictMatrix &conflicts, std::vector<int> &lanes); // conflicts between movements and lanes per approach
+    int getLeg(std::shared_ptr<Street> street);                         // index of the street within getStreets(), -1 if not connected
+
 private:
 
     // typical behaviour methods
     void processVehicleQueue();
+    void updateLayout();
 
     // private members
     std::vector<std::shared_ptr<Street>> _streets;   // list of all streets connected to this intersection
     WaitingVehicles _waitingVehicles; // list of all vehicles and their associated promises waiting to enter the intersection
-    bool _isBlocked;                  // flag indicating wether the intersection is blocked by a vehicle
     TrafficLight _trafficLight; // TrafficLight object part of each intersection
 };
 
@@ -0,0 +1,156 @@
+#ifndef MOVEMENTQUEUES_H
+#define MOVEMENTQUEUES_H
+
+#include <utility>
+#include <vector>
+#include "ConflictMatrix.h"
+#include "RingBuffer.h"
+
+// Waiting lines in front of one intersection, one per movement (approach x exit street), together with the
+// movements currently in use. Not thread-safe: WaitingVehicles guards it with a mutex, the stepped
+// SimulationEngine uses it from a single thread. T is whatever has to be handed out on admission.
+template <class T>
+class MovementQueues
+{
+public:
+    // getters / setters
+    int getSize() const { return _size; }                          // number of waiting vehicles in all queues
+    int getNumActive() const { return _activeVehicles.size(); }    // number of vehicles currently crossing
+    void setLayout(const ConflictMatrix &conflicts, const std::vector<int> &lanes); // lanes = number of lanes per approach
+
+    // typical behaviour methods
+    void push(int vehicleID, T &&item, int fromLeg, int toLeg);
+    // remove the next platoon of every approach whose movements do not conflict with the movements in use and
+    // hand each vehicle to permit(T &&item, int slot), slot being its position within the platoon counted per lane
+    template <class Permit>
+    int popPlatoons(int platoonSize, Permit &&permit);
+    void release(int vehicleID);     // vehicle has left the intersection, its movement is free again
+    template <class Permit>
+    void popAll(Permit &&permit);    // empty all queues regardless of conflicts
+
+private:
+    struct Entry
+    {
+        int vehicleID;
+        long arrival; // sequence number of arrival, to serve the queues of one approach in order
+        T item;
+    };
+
+    bool isConflictingWithActive(int movement) const;
+
+    std::vector<RingBuffer<Entry>> _queues;            // one queue per movement (approach x exit)
+    ConflictMatrix _conflicts;                        // which movements must not be used at the same time
+    std::vector<int> _lanes;                          // number of lanes per approach
+    std::vector<int> _activeApproaches;               // number of vehicles per approach currently crossing
+    std::vector<std::pair<int, int>> _activeVehicles; // vehicle id and movement of all vehicles currently crossing
+    int _size = 0;
+    long _arrivalCnt = 0;
+    int _nextApproach = 0;                            // approach served first in the next round, so that no approach starves
+};
+
+template <class T>
+void MovementQueues<T>::setLayout(const ConflictMatrix &conflicts, const std::vector<int> &lanes)
+{
+    _conflicts = conflicts;
+    _lanes = lanes;
+    _queues.resize(_conflicts.getNumMovements());
+    _activeApproaches.assign(_conflicts.getNumLegs(), 0);
+}
+
+template <class T>
+void MovementQueues<T>::push(int vehicleID, T &&item, int fromLeg, int toLeg)
+{
+    _queues.at(_conflicts.getMovement(fromLeg, toLeg)).push_back(Entry{vehicleID, _arrivalCnt++, std::move(item)});
+    _size++;
+}
+
+template <class T>
+template <class Permit>
+int MovementQueues<T>::popPlatoons(int platoonSize, Permit &&permit)
+{
+    int nLegs = _conflicts.getNumLegs();
+    int nPermitted = 0;
+    for (int na = 0; na < nLegs && _size > 0; na++)
+    {
+        int approach = (_nextApproach + na) % nLegs;
+
+        // serve the turn queues of this approach in order of arrival while the platoon has room on all lanes
+        int nInPlatoon = 0;
+        while (_activeApproaches[approach] < _lanes[approach] * platoonSize)
+        {
+            // find the movement whose first vehicle may enter, on a single lane only the first vehicle to arrive is eligible
+            int candidate = -1;
+            long candidateArrival = 0;
+            for (int exit = 0; exit < nLegs; exit++)
+            {
+                int movement = _conflicts.getMovement(approach, exit);
+                if (_queues[movement].empty())
+                    continue;
+                bool isEligible = _lanes[approach] > 1 ? !isConflictingWithActive(movement) : true;
+                if (isEligible && (candidate < 0 || _queues[movement].front().arrival < candidateArrival))
+                {
+                    candidate = movement;
+                    candidateArrival = _queues[movement].front().arrival;
+                }
+            }
+            if (candidate < 0 || isConflictingWithActive(candidate))
+                break;
+
+            // the movement is in use until the vehicle has left the intersection
+            Entry &first = _queues[candidate].front();
+            _activeVehicles.emplace_back(first.vehicleID, candidate);
+            _activeApproaches[approach]++;
+
+            // vehicles on parallel lanes of the same approach leave side by side
+            permit(std::move(first.item), nInPlatoon / _lanes[approach]);
+            _queues[candidate].pop_front();
+            _size--;
+            nInPlatoon++;
+            nPermitted++;
+        }
+    }
+    _nextApproach = nLegs > 0 ? (_nextApproach + 1) % nLegs : 0;
+
+    return nPermitted;
+}
+
+template <class T>
+bool MovementQueues<T>::isConflictingWithActive(int movement) const
+{
+    for (auto &active : _activeVehicles)
+    {
+        if (_conflicts.isConflicting(movement, active.second))
+            return true;
+    }
+    return false;
+}
+
+template <class T>
+void MovementQueues<T>::release(int vehicleID)
+{
+    for (auto it = _activeVehicles.begin(); it != _activeVehicles.end(); ++it)
+    {
+        if (it->first == vehicleID)
+        {
+            _activeApproaches[_conflicts.getFromLeg(it->second)]--;
+            _activeVehicles.erase(it);
+            return;
+        }
+    }
+}
+
+template <class T>
+template <class Permit>
+void MovementQueues<T>::popAll(Permit &&permit)
+{
+    for (auto &queue : _queues)
+    {
+        for (; !queue.empty(); queue.pop_front())
+        {
+            permit(std::move(queue.front().item), 0);
+        }
+    }
+    _size = 0;
+}
+
+#endif
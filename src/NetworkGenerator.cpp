@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+#include "Street.h"
+#include "Intersection.h"
+#include "Scenario.h"
+#include "NetworkGenerator.h"
+
+namespace
+{
+// independent random streams drawn for the same street or intersection
+enum RandomStream : uint64_t
+{
+    streamKeep,
+    streamLength,
+    streamJitterX,
+    streamJitterY,
+    streamDiagonal,
+    streamDirection,
+};
+
+const double canvasExtent = 4000.0; // longer side of the network in pixels, similar to the city maps
+const size_t maxHubStreets = 8;     // streets from the hub of a radial network to its first ring
+const size_t minRangeSize = 4096;   // intersections per thread below which more threads do not pay off
+
+// bounds of contiguous ranges of n items, one per thread
+std::vector<size_t> splitRanges(size_t n)
+{
+    size_t nRanges = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), n / minRangeSize));
+    std::vector<size_t> bounds;
+    for (size_t nr = 0; nr <= nRanges; nr++)
+    {
+        bounds.push_back(n * nr / nRanges);
+    }
+    return bounds;
+}
+
+// run work(range, begin, end) for every range on a thread of its own and wait for all of them
+template <typename Work>
+void forEachRange(const std::vector<size_t> &bounds, Work work)
+{
+    std::vector<std::thread> threads;
+    for (size_t nr = 0; nr + 1 < bounds.size(); nr++)
+    {
+        threads.emplace_back(std::thread(work, nr, bounds[nr], bounds[nr + 1]));
+    }
+    std::for_each(threads.begin(), threads.end(), [](std::thread &t) {
+        t.join();
+    });
+}
+} // namespace
+
+/* Implementation of class "NetworkGenerator" */
+
+NetworkGenerator::NetworkGenerator(std::shared_ptr<SimulationContext> context) : _context(context), _rows(0), _cols(0), _rings(0), _spokes(0)
+{
+    parseMap(context->getConfig().map, _layout, _nIntersections);
+
+    if (_layout == layoutRadial)
+    {
+        // about as many spokes as the outermost ring is long, so that its intersections are evenly spaced
+        const double pi = std::acos(-1.0);
+        _rings = std::max<size_t>(1, std::lround(std::sqrt((_nIntersections - 1) / (2.0 * pi))));
+        _spokes = (_nIntersections - 1 + _rings - 1) / _rings;
+        _spacing = canvasExtent / (2.0 * _rings + 1.0);
+    }
+    else
+    {
+        _cols = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(_nIntersections))));
+        _rows = (_nIntersections + _cols - 1) / _cols;
+        _spacing = canvasExtent / std::max(_rows, _cols);
+    }
+
+    // a time-based seed is drawn once, all choices are derived from it
+    _seed = _context->nextSeed();
+}
+
+void NetworkGenerator::parseMap(const std::string &map, Layout &layout, size_t &nIntersections)
+{
+    // map names look like "grid:1000"
+    size_t separator = map.find(':');
+    std::string name = map.substr(0, separator);
+    if (name == "grid")
+        layout = layoutGrid;
+    else if (name == "radial")
+        layout = layoutRadial;
+    else if (name == "planar")
+        layout = layoutPlanar;
+    else
+        throw std::invalid_argument("unknown network layout " + name + ", use grid, radial or planar");
+
+    long n = separator == std::string::npos ? 0 : std::atol(map.c_str() + separator + 1);
+    if (n < 2)
+        throw std::invalid_argument("generated network " + map + " needs at least 2 intersections");
+    nIntersections = n;
+}
+
+void NetworkGenerator::validate(const std::string &map)
+{
+    Layout layout;
+    size_t nIntersections;
+    parseMap(map, layout, nIntersections);
+}
+
+bool NetworkGenerator::isGenerated(const std::string &map)
+{
+    std::string layout = map.substr(0, map.find(':'));
+    return layout == "grid" || layout == "radial" || layout == "planar";
+}
+
+void NetworkGenerator::getCanvasSize(double &width, double &height) const
+{
+    if (_layout == layoutRadial)
+    {
+        width = height = (2.0 * _rings + 1.0) * _spacing;
+    }
+    else
+    {
+        width = _cols * _spacing;
+        height = _rows * _spacing;
+    }
+}
+
+double NetworkGenerator::random(uint64_t key, uint64_t stream) const
+{
+    // splitmix64 finalizer over seed, key and stream
+    uint64_t z = _seed + key * 0x9E3779B97F4A7C15ull + stream * 0xD1B54A32D192ED03ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z = z ^ (z >> 31);
+    return (z >> 11) * (1.0 / (1ull << 53));
+}
+
+void NetworkGenerator::getPosition(size_t intersection, double &x, double &y) const
+{
+    if (_layout == layoutRadial)
+    {
+        // hub in the centre, ring k at a radius of k + 1 spacings
+        double centre = (_rings + 0.5) * _spacing;
+        x = y = centre;
+        if (intersection > 0)
+        {
+            const double pi = std::acos(-1.0);
+            size_t ring = (intersection - 1) / _spokes, spoke = (intersection - 1) % _spokes;
+            double angle = 2.0 * pi * spoke / _spokes;
+            x += (ring + 1) * _spacing * std::cos(angle);
+            y += (ring + 1) * _spacing * std::sin(angle);
+        }
+        return;
+    }
+
+    x = (intersection % _cols + 0.5) * _spacing;
+    y = (intersection / _cols + 0.5) * _spacing;
+    if (_layout == layoutPlanar)
+    {
+        // by at most a quarter spacing, which keeps every lattice cell convex and its diagonal inside
+        x += (random(intersection, streamJitterX) - 0.5) * 0.5 * _spacing;
+        y += (random(intersection, streamJitterY) - 0.5) * 0.5 * _spacing;
+    }
+}
+
+void NetworkGenerator::getCandidates(size_t intersection, std::vector<Candidate> &candidates) const
+{
+    candidates.clear();
+    auto addCandidate = [this, intersection, &candidates](size_t out, bool isTree) {
+        if (out < _nIntersections)
+            candidates.push_back(Candidate{out, isTree, intersection * _nIntersections + out});
+    };
+
+    if (_layout == layoutRadial)
+    {
+        if (intersection == 0)
+        {
+            // only a few streets lead to the hub, the first ring connects the others
+            size_t hubStreets = std::min(_spokes, maxHubStreets);
+            for (size_t ns = 0; ns < hubStreets; ns++)
+            {
+                addCandidate(1 + ns * _spokes / hubStreets, true);
+            }
+            return;
+        }
+        size_t ring = (intersection - 1) / _spokes, spoke = (intersection - 1) % _spokes;
+        addCandidate(intersection + _spokes, true); // outwards along the spoke
+        if (_spokes >= 3)
+            addCandidate(1 + ring * _spokes + (spoke + 1) % _spokes, ring == 0); // along the ring
+        return;
+    }
+
+    // the rows and the first column form the spanning tree
+    size_t row = intersection / _cols, col = intersection % _cols;
+    if (col + 1 < _cols)
+        addCandidate(intersection + 1, true);
+    addCandidate(intersection + _cols, col == 0);
+    if (_layout == layoutPlanar && row + 1 < _rows)
+    {
+        // one diagonal per cell: '\' starts at the cell's top left corner, '/' at its top right corner
+        if (col + 1 < _cols && random(intersection, streamDiagonal) < 0.5)
+            addCandidate(intersection + _cols + 1, false);
+        if (col > 0 && random(intersection - 1, streamDiagonal) >= 0.5)
+            addCandidate(intersection + _cols - 1, false);
+    }
+}
+
+void NetworkGenerator::generate(std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections,
+                                std::vector<VehiclePlacement> &placements, int nVehicles)
+{
+    const ScenarioConfig &config = _context->getConfig();
+    std::vector<size_t> bounds = splitRanges(_nIntersections);
+    size_t nRanges = bounds.size() - 1;
+
+    // create and position the intersections of every range and collect the streets which may start there
+    intersections.assign(_nIntersections, nullptr);
+    std::vector<std::vector<Link>> links(nRanges);
+    std::vector<size_t> nTree(nRanges, 0), nOptional(nRanges, 0);
+    forEachRange(bounds, [&](size_t range, size_t begin, size_t end) {
+        std::vector<Candidate> candidates;
+        for (size_t ni = begin; ni < end; ni++)
+        {
+            intersections[ni] = std::make_shared<Intersection>(_context);
+            double x, y;
+            getPosition(ni, x, y);
+            intersections[ni]->setPosition(x, y);
+
+            getCandidates(ni, candidates);
+            for (auto &candidate : candidates)
+            {
+                (candidate.isTree ? nTree : nOptional)[range]++;
+            }
+        }
+    });
+
+    // keep the streets outside the spanning tree with the probability which yields the mean degree
+    size_t treeStreets = 0, optionalStreets = 0;
+    for (size_t nr = 0; nr < nRanges; nr++)
+    {
+        treeStreets += nTree[nr];
+        optionalStreets += nOptional[nr];
+    }
+    double keepProbability = 1.0;
+    if (config.meanDegree > 0.0 && optionalStreets > 0)
+    {
+        double targetStreets = config.meanDegree * _nIntersections / 2.0;
+        keepProbability = std::max(0.0, std::min(1.0, (targetStreets - treeStreets) / optionalStreets));
+    }
+    forEachRange(bounds, [&](size_t range, size_t begin, size_t end) {
+        std::vector<Candidate> candidates;
+        for (size_t ni = begin; ni < end; ni++)
+        {
+            getCandidates(ni, candidates);
+            for (auto &candidate : candidates)
+            {
+                if (!candidate.isTree && random(candidate.key, streamKeep) >= keepProbability)
+                    continue;
+                double length = config.minStreetLength + (config.maxStreetLength - config.minStreetLength) * random(candidate.key, streamLength);
+                links[range].push_back(Link{ni, candidate.out, length});
+            }
+        }
+    });
+
+    // streets are numbered range by range, in the order of the intersections they start from
+    std::vector<size_t> offsets(nRanges + 1, 0);
+    for (size_t nr = 0; nr < nRanges; nr++)
+    {
+        offsets[nr + 1] = offsets[nr] + links[nr].size();
+    }
+    size_t nStreets = offsets[nRanges];
+    streets.assign(nStreets, nullptr);
+
+    // first pass: every range creates its streets and connects the intersections they start from
+    forEachRange(bounds, [&](size_t range, size_t, size_t) {
+        for (size_t nl = 0; nl < links[range].size(); nl++)
+        {
+            const Link &link = links[range][nl];
+            std::shared_ptr<Street> street = std::make_shared<Street>(_context);
+            street->setLanes(config.lanes);
+            street->setLength(link.length);
+            street->setInIntersection(intersections[link.in]);
+            streets[offsets[range] + nl] = street;
+        }
+    });
+
+    // second pass: every range connects the streets ending at its intersections, found through a counting sort
+    std::vector<size_t> endOffsets(_nIntersections + 1, 0);
+    for (size_t nr = 0; nr < nRanges; nr++)
+    {
+        for (auto &link : links[nr])
+        {
+            endOffsets[link.out + 1]++;
+        }
+    }
+    for (size_t ni = 0; ni < _nIntersections; ni++)
+    {
+        endOffsets[ni + 1] += endOffsets[ni];
+    }
+    std::vector<size_t> endingStreets(nStreets), fill(endOffsets.begin(), endOffsets.end() - 1);
+    for (size_t nr = 0; nr < nRanges; nr++)
+    {
+        for (size_t nl = 0; nl < links[nr].size(); nl++)
+        {
+            endingStreets[fill[links[nr][nl].out]++] = offsets[nr] + nl;
+        }
+    }
+    forEachRange(bounds, [&](size_t, size_t begin, size_t end) {
+        for (size_t ni = begin; ni < end; ni++)
+        {
+            for (size_t ne = endOffsets[ni]; ne < endOffsets[ni + 1]; ne++)
+            {
+                streets[endingStreets[ne]]->setOutIntersection(intersections[ni]);
+            }
+        }
+    });
+
+    // spread the vehicles over all streets, each one driving towards a random end of its street
+    placements.assign(nVehicles, VehiclePlacement{0, 0});
+    forEachRange(splitRanges(nVehicles), [&](size_t, size_t begin, size_t end) {
+        for (size_t nv = begin; nv < end; nv++)
+        {
+            size_t street = nv % nStreets;
+            size_t range = std::upper_bound(offsets.begin(), offsets.end(), street) - offsets.begin() - 1;
+            const Link &link = links[range][street - offsets[range]];
+            size_t destination = random(nv, streamDirection) < 0.5 ? link.out : link.in;
+            placements[nv] = VehiclePlacement{static_cast<int>(street), static_cast<int>(destination)};
+        }
+    });
+}
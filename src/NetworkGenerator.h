@@ -0,0 +1,79 @@
+#ifndef NETWORKGENERATOR_H
+#define NETWORKGENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "SimulationContext.h"
+
+// forward declarations to avoid include cycle
+class Street;
+class Intersection;
+struct VehiclePlacement;
+
+// Builds synthetic street networks for scale tests from a map name "<layout>:<intersections>":
+//   grid:N    rectangular grid, every intersection connected to its horizontal and vertical neighbours
+//   radial:N  hub with rings around it, connected by spokes and along the rings
+//   planar:N  jittered lattice triangulated by one random diagonal per cell, so that no two streets cross
+// Every layout first enumerates its candidate streets, of which those of a spanning tree are always kept and the
+// others with the probability that yields ScenarioConfig::meanDegree. Street lengths are drawn uniformly from
+// [minStreetLength, maxStreetLength]. All random choices hash the position in the layout instead of drawing from
+// a sequential generator, so the network only depends on the seed, not on the number of threads building it.
+//
+// The intersections are split into one contiguous range per thread. Each thread creates the intersections of its
+// range and the streets starting there, and in a second pass connects the streets ending there, so that no two
+// threads ever add streets to the same intersection.
+class NetworkGenerator
+{
+public:
+    // constructor / destructor
+    NetworkGenerator(std::shared_ptr<SimulationContext> context); // throws std::invalid_argument for an unknown layout
+
+    // getters / setters
+    static bool isGenerated(const std::string &map); // true for map names handled by this generator
+    static void validate(const std::string &map);    // throws std::invalid_argument like the constructor, without drawing a seed
+    void getCanvasSize(double &width, double &height) const; // pixel extent of the network including a margin
+
+    // typical behaviour methods
+    void generate(std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections,
+                  std::vector<VehiclePlacement> &placements, int nVehicles);
+
+private:
+    enum Layout
+    {
+        layoutGrid,
+        layoutRadial,
+        layoutPlanar,
+    };
+
+    struct Candidate
+    {
+        size_t out;  // intersection at the other end, the street starts at the intersection enumerating it
+        bool isTree; // part of the spanning tree which keeps the network connected
+        uint64_t key; // identifies the street for the random choices
+    };
+
+    struct Link
+    {
+        size_t in, out;
+        double length;
+    };
+
+    // typical behaviour methods
+    static void parseMap(const std::string &map, Layout &layout, size_t &nIntersections);
+    void getPosition(size_t intersection, double &x, double &y) const;
+    void getCandidates(size_t intersection, std::vector<Candidate> &candidates) const;
+    double random(uint64_t key, uint64_t stream) const; // uniform in [0, 1), a pure function of the seed and its arguments
+
+    std::shared_ptr<SimulationContext> _context;
+    Layout _layout;
+    size_t _nIntersections;
+    size_t _rows, _cols;     // grid and planar layouts: lattice size, the last row may be incomplete
+    size_t _rings, _spokes;  // radial layout: intersections around the hub
+    double _spacing;         // distance between neighbouring intersections in pixels
+    uint64_t _seed;
+};
+
+#endif
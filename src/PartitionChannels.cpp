@@ -0,0 +1,131 @@
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <sys/mman.h>
+
+#include "EngineProtocol.h"
+#include "PartitionChannels.h"
+
+/* Implementation of class "PartitionChannels" */
+
+PartitionChannels::PartitionChannels(int nPartitions, size_t capacity) : _nPartitions(nPartitions), _partition(0)
+{
+    _capacity = 1;
+    while (_capacity < capacity)
+    {
+        _capacity *= 2;
+    }
+
+    // header, statistics and rings each start on a cache line of their own
+    auto alignUp = [](size_t size) { return (size + 63) / 64 * 64; };
+    size_t headerSize = alignUp(sizeof(Header));
+    size_t statsSize = alignUp(nPartitions * sizeof(SimulationStats));
+    _ringSize = alignUp(sizeof(Ring) + _capacity * sizeof(VehicleHandoff));
+    _segmentSize = headerSize + statsSize + nPartitions * nPartitions * _ringSize;
+
+    // anonymous shared memory is inherited by the processes forked later on
+    _segment = ::mmap(nullptr, _segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (_segment == MAP_FAILED)
+        throw systemError("mmap partition channels");
+
+    char *segment = static_cast<char *>(_segment);
+    _header = new (segment) Header();
+    _header->arrived = 0;
+    _header->generation = 0;
+    _stats = reinterpret_cast<SimulationStats *>(segment + headerSize);
+    for (int np = 0; np < nPartitions; np++)
+    {
+        new (&_stats[np]) SimulationStats();
+    }
+    _rings = segment + headerSize + statsSize;
+    for (int from = 0; from < nPartitions; from++)
+    {
+        for (int to = 0; to < nPartitions; to++)
+        {
+            Ring *ring = new (&getRing(from, to)) Ring();
+            ring->head = 0;
+            ring->tail = 0;
+        }
+    }
+}
+
+PartitionChannels::~PartitionChannels()
+{
+    ::munmap(_segment, _segmentSize);
+}
+
+PartitionChannels::Ring &PartitionChannels::getRing(int from, int to)
+{
+    return *reinterpret_cast<Ring *>(_rings + (from * _nPartitions + to) * _ringSize);
+}
+
+VehicleHandoff *PartitionChannels::getSlots(int from, int to)
+{
+    return reinterpret_cast<VehicleHandoff *>(_rings + (from * _nPartitions + to) * _ringSize + sizeof(Ring));
+}
+
+SimulationStats PartitionChannels::getStats(int partition) const
+{
+    return _stats[partition];
+}
+
+void PartitionChannels::setStats(const SimulationStats &stats)
+{
+    _stats[_partition] = stats;
+}
+
+void PartitionChannels::send(int partition, const VehicleHandoff &handoff)
+{
+    Ring &ring = getRing(_partition, partition);
+    uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+
+    // the receiver may itself be waiting for room in one of our rings, so keep receiving while the ring is full
+    while (tail - ring.head.load(std::memory_order_acquire) >= _capacity)
+    {
+        drain();
+        std::this_thread::yield();
+    }
+    getSlots(_partition, partition)[tail & (_capacity - 1)] = handoff;
+    ring.tail.store(tail + 1, std::memory_order_release);
+}
+
+void PartitionChannels::drain()
+{
+    for (int from = 0; from < _nPartitions; from++)
+    {
+        Ring &ring = getRing(from, _partition);
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+        uint64_t tail = ring.tail.load(std::memory_order_acquire);
+        const VehicleHandoff *slots = getSlots(from, _partition);
+        for (; head != tail; head++)
+        {
+            _received.push_back(slots[head & (_capacity - 1)]);
+        }
+        ring.head.store(head, std::memory_order_release);
+    }
+}
+
+void PartitionChannels::barrier()
+{
+    // the last partition to arrive opens the barrier for the current generation
+    uint32_t generation = _header->generation.load(std::memory_order_acquire);
+    if (_header->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == static_cast<uint32_t>(_nPartitions))
+    {
+        _header->arrived.store(0, std::memory_order_relaxed);
+        _header->generation.store(generation + 1, std::memory_order_release);
+        return;
+    }
+    while (_header->generation.load(std::memory_order_acquire) == generation)
+    {
+        drain();
+        std::this_thread::yield();
+    }
+}
+
+std::vector<VehicleHandoff> PartitionChannels::takeReceived()
+{
+    drain();
+    std::vector<VehicleHandoff> received;
+    received.swap(_received);
+    return received;
+}
@@ -0,0 +1,67 @@
+#ifndef PARTITIONCHANNELS_H
+#define PARTITIONCHANNELS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "SimulationContext.h"
+#include "EngineState.h"
+
+// Communication between the processes of a PartitionedSimulation. The parent maps one shared anonymous segment
+// before forking, holding a single-producer / single-consumer ring of vehicle handoffs for every ordered pair
+// of partitions, a barrier and one statistics slot per partition. After fork, each process attaches as its
+// partition. Whenever a process waits, either for room in a full ring or at the barrier, it keeps draining its
+// own incoming rings, so that partitions sending to each other cannot block one another.
+class PartitionChannels
+{
+public:
+    // constructor / destructor
+    PartitionChannels(int nPartitions, size_t capacity); // capacity = handoffs per ring, rounded up to a power of 2, throws std::runtime_error
+    ~PartitionChannels();
+
+    // getters / setters
+    int getNumPartitions() const { return _nPartitions; }
+    void attach(int partition) { _partition = partition; } // called once in each process after fork
+    SimulationStats getStats(int partition) const;
+    void setStats(const SimulationStats &stats);            // statistics of the attached partition
+
+    // typical behaviour methods
+    void send(int partition, const VehicleHandoff &handoff);
+    void barrier();                            // wait until all partitions have arrived
+    std::vector<VehicleHandoff> takeReceived(); // all handoffs received by the attached partition so far
+
+private:
+    struct Ring
+    {
+        alignas(64) std::atomic<uint64_t> head; // next slot to read, written by the receiver only
+        alignas(64) std::atomic<uint64_t> tail; // next slot to write, written by the sender only
+    };
+
+    struct Header
+    {
+        alignas(64) std::atomic<uint32_t> arrived;    // partitions which have arrived at the current barrier
+        alignas(64) std::atomic<uint32_t> generation; // incremented when all partitions have arrived
+    };
+
+    // typical behaviour methods
+    Ring &getRing(int from, int to);
+    VehicleHandoff *getSlots(int from, int to);
+    void drain();
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+                  "atomics in shared memory have to be lock-free");
+
+    int _nPartitions;
+    int _partition;
+    size_t _capacity;
+    size_t _ringSize; // bytes per ring including its slots
+    void *_segment;
+    size_t _segmentSize;
+    Header *_header;
+    SimulationStats *_stats;
+    char *_rings;
+    std::vector<VehicleHandoff> _received;
+};
+
+#endif
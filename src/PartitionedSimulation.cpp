@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Street.h"
+#include "Intersection.h"
+#include "Scenario.h"
+#include "SimulationEngine.h"
+#include "VehicleRegistry.h"
+#include "PartitionChannels.h"
+#include "PartitionedSimulation.h"
+
+/* Implementation of class "PartitionedSimulation" */
+
+PartitionedSimulation::PartitionedSimulation(const ScenarioConfig &config, int nPartitions)
+    : _config(config), _nPartitions(std::max(1, nPartitions)), _lookahead(0.0)
+{
+}
+
+std::vector<int> PartitionedSimulation::partitionIntersections(const std::vector<std::shared_ptr<Intersection>> &intersections, int nPartitions)
+{
+    // cut the map into strips across its longer side, so that few streets connect different partitions
+    std::vector<double> xs, ys;
+    for (auto &intersection : intersections)
+    {
+        double x, y;
+        intersection->getPosition(x, y);
+        xs.push_back(x);
+        ys.push_back(y);
+    }
+    bool isWide = intersections.empty() || *std::max_element(xs.begin(), xs.end()) - *std::min_element(xs.begin(), xs.end()) >=
+                                               *std::max_element(ys.begin(), ys.end()) - *std::min_element(ys.begin(), ys.end());
+    const std::vector<double> &coordinates = isWide ? xs : ys;
+
+    std::vector<int> order(intersections.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&coordinates](int a, int b) { return coordinates[a] < coordinates[b]; });
+
+    std::vector<int> owners(intersections.size());
+    for (size_t n = 0; n < order.size(); n++)
+    {
+        owners[order[n]] = n * nPartitions / order.size();
+    }
+    return owners;
+}
+
+SimulationStats PartitionedSimulation::run()
+{
+    // the network is built once and inherited by all partitions, which create the vehicles heading for their own
+    // intersections only, so that no process ever holds the whole fleet
+    Scenario scenario(_config, false);
+    _owners = partitionIntersections(scenario.getIntersections(), _nPartitions);
+
+    // the lookahead is the same in all partitions, as they have to meet at the same times; the index of the network
+    // is built here, so that all partitions share it instead of building their own
+    _lookahead = std::numeric_limits<double>::infinity();
+    const EngineNetwork &network = scenario.getNetwork();
+    TravelTimeFunction travelTime = findVehicleModel(_config.motionModel, _config.routingPolicy).travelTime;
+    for (size_t ns = 0; ns < network.streets.size(); ns++)
+    {
+        if (_owners[network.streetIns[ns]] != _owners[network.streetOuts[ns]])
+            _lookahead = std::min(_lookahead, travelTime(_config.vehicleSpeed, network.streets[ns]->getLength(), 0.0, 0.9, false));
+    }
+    // the windows are one step shorter than the lookahead (see runPartition()), so it has to span two steps at least
+    if (std::isfinite(_lookahead) && static_cast<long>(_lookahead / SimulationEngine::stepDuration) < 2)
+        throw std::runtime_error("streets between partitions are too short for a window of one step, use fewer partitions or longer streets");
+
+    PartitionChannels channels(_nPartitions, 1024);
+    std::cout.flush(); // buffered output would otherwise be written by every partition
+
+    std::vector<pid_t> pids;
+    auto killPartitions = [&pids]() {
+        for (pid_t pid : pids)
+        {
+            ::kill(pid, SIGKILL);
+        }
+    };
+    for (int np = 0; np < _nPartitions; np++)
+    {
+        pid_t pid = ::fork();
+        if (pid < 0)
+        {
+            killPartitions();
+            throw std::runtime_error("could not start partition " + std::to_string(np));
+        }
+        if (pid == 0)
+        {
+            int status = 0;
+            try
+            {
+                runPartition(scenario, channels, np);
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Partition " << np << ": " << e.what() << std::endl;
+                status = 1;
+            }
+            ::_exit(status);
+        }
+        pids.push_back(pid);
+    }
+
+    // a partition which fails would leave the others waiting at the next barrier forever
+    bool isFailed = false;
+    for (size_t n = 0; n < pids.size(); n++)
+    {
+        int status;
+        if (::waitpid(-1, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            if (!isFailed)
+                killPartitions();
+            isFailed = true;
+        }
+    }
+    if (isFailed)
+        throw std::runtime_error("partitioned simulation failed");
+
+    SimulationStats stats;
+    for (int np = 0; np < _nPartitions; np++)
+    {
+        stats.merge(channels.getStats(np));
+    }
+    stats.runs = 1;
+    stats.duration = _config.duration;
+    return stats;
+}
+
+void PartitionedSimulation::runPartition(Scenario &scenario, PartitionChannels &channels, int partition)
+{
+    channels.attach(partition);
+    std::vector<bool> isOwned(_owners.size());
+    for (size_t ni = 0; ni < _owners.size(); ni++)
+    {
+        isOwned[ni] = _owners[ni] == partition;
+    }
+    SimulationEngine engine(scenario, isOwned);
+
+    // one step less than the lookahead, as the stepped mode may reach the halting position up to a step early
+    long nSteps = std::lround(_config.duration / SimulationEngine::stepDuration);
+    long windowSteps = nSteps;
+    if (std::isfinite(_lookahead))
+        windowSteps = std::min(nSteps, static_cast<long>(_lookahead / SimulationEngine::stepDuration) - 1);
+
+    for (long n = 0; n < nSteps; n += windowSteps)
+    {
+        engine.step(std::min(windowSteps, nSteps - n));
+        for (auto &handoff : engine.takeHandoffs())
+        {
+            channels.send(_owners[handoff.destination], handoff);
+        }
+
+        // all handoffs of this window have been sent once every partition has arrived
+        channels.barrier();
+        for (auto &handoff : channels.takeReceived())
+        {
+            engine.acceptVehicle(handoff);
+        }
+        // and nobody sends handoffs of the next window before all of them have been received
+        channels.barrier();
+    }
+
+    channels.setStats(engine.getStats());
+}
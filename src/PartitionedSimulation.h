@@ -0,0 +1,46 @@
+#ifndef PARTITIONEDSIMULATION_H
+#define PARTITIONEDSIMULATION_H
+
+#include <memory>
+#include <vector>
+#include "SimulationContext.h"
+
+// forward declarations to avoid include cycle
+class Intersection;
+class PartitionChannels;
+class Scenario;
+
+// Runs one scenario on several local processes. The intersections are split into spatial strips, one per
+// partition; each process runs a SimulationEngine owning its strip, and vehicles crossing into another strip
+// are handed over through shared memory rings (see PartitionChannels). All partitions advance in windows of
+// the lookahead, the shortest free-flow time from entering a street between two partitions to its halting
+// position: a vehicle handed over during a window cannot reach an intersection of its new partition before
+// the window has ended, so the partitions only have to meet once per window. The street network is built before the
+// processes are started and shared with them copy-on-write; each process only creates the vehicles heading for its strip
+// and keeps lights and queues for the intersections of its strip.
+class PartitionedSimulation
+{
+public:
+    // constructor / destructor
+    PartitionedSimulation(const ScenarioConfig &config, int nPartitions);
+
+    // getters / setters
+    double getLookahead() const { return _lookahead; }          // valid after run()
+    const std::vector<int> &getOwners() const { return _owners; } // partition of every intersection, valid after run()
+
+    // typical behaviour methods
+    SimulationStats run(); // simulate config.duration s, throws std::runtime_error if the lookahead is shorter than two steps or a partition process fails
+
+    static std::vector<int> partitionIntersections(const std::vector<std::shared_ptr<Intersection>> &intersections, int nPartitions);
+
+private:
+    // typical behaviour methods
+    void runPartition(Scenario &scenario, PartitionChannels &channels, int partition);
+
+    ScenarioConfig _config;
+    int _nPartitions;
+    std::vector<int> _owners;
+    double _lookahead;
+};
+
+#endif
@@ -0,0 +1,204 @@
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Profiler.h"
+
+namespace
+{
+    struct ProfileEvent
+    {
+        const char *name;
+        long long start; // in microseconds since the profiler epoch
+        long long duration;
+    };
+
+    // fixed-size chunk of events, appended to by its owning thread only
+    struct ProfileBlock
+    {
+        static const size_t capacity = 256; // small, as most threads only record a few events
+        ProfileEvent events[capacity];
+        std::atomic<size_t> count{0};               // published with release semantics after an event has been written
+        std::atomic<ProfileBlock *> next{nullptr};
+    };
+
+    // events of one thread at a time; outlives the thread so that the trace can be exported afterwards
+    struct ThreadBuffer
+    {
+        ProfileBlock *head;
+        ProfileBlock *tail; // only touched by the owning thread
+        int tid;
+        std::string name;   // protected by ProfileRegistry::mutex
+        bool isRecycled;    // holds events of threads which have exited, protected by ProfileRegistry::mutex
+    };
+
+    struct ProfileRegistry
+    {
+        std::mutex mutex; // only taken when a thread records its first event, names itself, exits or the trace is exported
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        std::vector<ThreadBuffer *> freeBuffers; // unnamed buffers of exited threads, handed to the next new thread
+        std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+        ~ProfileRegistry()
+        {
+            for (auto &buffer : buffers)
+            {
+                for (ProfileBlock *block = buffer->head; block;)
+                {
+                    ProfileBlock *next = block->next.load();
+                    delete block;
+                    block = next;
+                }
+            }
+        }
+
+        // called with the mutex held
+        ThreadBuffer *acquire(bool isReusable)
+        {
+            if (isReusable && !freeBuffers.empty())
+            {
+                ThreadBuffer *buffer = freeBuffers.back();
+                freeBuffers.pop_back();
+                return buffer;
+            }
+            buffers.emplace_back(new ThreadBuffer{nullptr, nullptr, static_cast<int>(buffers.size()) + 1, "", false});
+            ThreadBuffer *buffer = buffers.back().get();
+            buffer->head = buffer->tail = new ProfileBlock();
+            return buffer;
+        }
+    };
+
+    ProfileRegistry &getRegistry()
+    {
+        static ProfileRegistry registry;
+        return registry;
+    }
+
+    // the buffer of the calling thread, returned to the registry when the thread exits
+    struct ThreadBufferOwner
+    {
+        ThreadBuffer *buffer = nullptr;
+
+        ~ThreadBufferOwner()
+        {
+            // std::async starts a thread per intersection crossing, so unnamed buffers are recycled
+            // instead of adding a buffer and a trace row for every one of them
+            if (!buffer)
+                return;
+            ProfileRegistry &registry = getRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            if (buffer->name.empty())
+            {
+                buffer->isRecycled = true;
+                registry.freeBuffers.push_back(buffer);
+            }
+        }
+    };
+
+    thread_local ThreadBufferOwner threadBufferOwner;
+
+    ThreadBuffer &getThreadBuffer()
+    {
+        if (!threadBufferOwner.buffer)
+        {
+            ProfileRegistry &registry = getRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            threadBufferOwner.buffer = registry.acquire(true);
+        }
+        return *threadBufferOwner.buffer;
+    }
+
+    // escape characters which are not allowed inside a JSON string
+    std::string escapeJson(const std::string &text)
+    {
+        std::string escaped;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+}
+
+std::atomic<bool> Profiler::_isEnabled(false);
+
+long long Profiler::now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - getRegistry().epoch).count();
+}
+
+void Profiler::setThreadName(const std::string &name)
+{
+    if (!isEnabled())
+        return;
+
+    ThreadBuffer &buffer = getThreadBuffer();
+    ProfileRegistry &registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (buffer.isRecycled)
+    {
+        // the events of earlier threads in this buffer must not carry the name, so give it back and start a new one
+        registry.freeBuffers.push_back(&buffer);
+        threadBufferOwner.buffer = registry.acquire(false);
+    }
+    threadBufferOwner.buffer->name = name;
+}
+
+void Profiler::record(const char *name, long long start, long long end)
+{
+    ThreadBuffer &buffer = getThreadBuffer();
+
+    // start a new block once the current one is full
+    ProfileBlock *block = buffer.tail;
+    size_t count = block->count.load(std::memory_order_relaxed);
+    if (count == ProfileBlock::capacity)
+    {
+        ProfileBlock *next = new ProfileBlock();
+        block->next.store(next, std::memory_order_release);
+        buffer.tail = block = next;
+        count = 0;
+    }
+
+    block->events[count] = ProfileEvent{name, start, end - start};
+    block->count.store(count + 1, std::memory_order_release);
+}
+
+bool Profiler::exportChromeTrace(const std::string &filename)
+{
+    std::ofstream file(filename);
+    if (!file)
+        return false;
+
+    ProfileRegistry &registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    // complete events ("ph":"X") of all threads, preceded by a thread name record for each named thread
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool isFirst = true;
+    for (auto &buffer : registry.buffers)
+    {
+        if (!buffer->name.empty())
+        {
+            file << (isFirst ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+                 << ",\"args\":{\"name\":\"" << escapeJson(buffer->name) << "\"}}";
+            isFirst = false;
+        }
+        for (ProfileBlock *block = buffer->head; block; block = block->next.load(std::memory_order_acquire))
+        {
+            size_t count = block->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; i++)
+            {
+                const ProfileEvent &event = block->events[i];
+                file << (isFirst ? "" : ",") << "\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                     << ",\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+                isFirst = false;
+            }
+        }
+    }
+    file << "\n]}\n";
+
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,56 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+/*
+ * Scoped timing zones which are recorded into per-thread buffers and exported as Chrome trace JSON
+ * (open in https://ui.perfetto.dev or chrome://tracing). Recording is switched on at runtime; while it
+ * is off, a zone costs a single relaxed atomic load. The buffers of unnamed threads are reused once their
+ * thread has exited, so that short-lived threads such as those of std::async share a few rows of the trace.
+ */
+class Profiler
+{
+public:
+    // getters / setters
+    static bool isEnabled() { return _isEnabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool isEnabled) { _isEnabled.store(isEnabled, std::memory_order_relaxed); }
+    static void setThreadName(const std::string &name); // label of the calling thread in the trace
+    static long long now();                             // microseconds since the profiler epoch
+
+    // typical behaviour methods
+    static void record(const char *name, long long start, long long end); // name must outlive the profiler, e.g. a literal
+    static bool exportChromeTrace(const std::string &filename);
+
+private:
+    static std::atomic<bool> _isEnabled;
+};
+
+// records the time between its construction and destruction as one event of the calling thread
+class ProfileZone
+{
+public:
+    // constructor / destructor
+    ProfileZone(const char *name) : _name(Profiler::isEnabled() ? name : nullptr)
+    {
+        if (_name)
+            _start = Profiler::now();
+    }
+    ~ProfileZone()
+    {
+        if (_name)
+            Profiler::record(_name, _start, Profiler::now());
+    }
+
+private:
+    const char *_name; // nullptr if the profiler was disabled when the zone was entered
+    long long _start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+
+#endif
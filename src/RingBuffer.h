@@ -0,0 +1,76 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// FIFO queue on a contiguous circular buffer which grows by doubling, so that
+// pushing to the back and popping from the front are O(1) without per-element allocations
+template <class T>
+class RingBuffer
+{
+public:
+    // constructor / destructor
+    RingBuffer() : _capacity(0), _head(0), _size(0) {}
+    RingBuffer(RingBuffer &&other) noexcept : _slots(std::move(other._slots)), _capacity(other._capacity), _head(other._head), _size(other._size)
+    {
+        other._capacity = other._head = other._size = 0;
+    }
+    ~RingBuffer() { clear(); }
+
+    // getters / setters
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    T &front() { return at(0); }
+    T &at(size_t i) { return *reinterpret_cast<T *>(&_slots[(_head + i) & (_capacity - 1)]); }
+
+    // typical behaviour methods
+    void push_back(T &&value)
+    {
+        if (_size == _capacity)
+            grow();
+        new (&_slots[(_head + _size) & (_capacity - 1)]) T(std::move(value));
+        _size++;
+    }
+
+    void pop_front()
+    {
+        front().~T();
+        _head = (_head + 1) & (_capacity - 1);
+        _size--;
+    }
+
+    void clear()
+    {
+        while (!empty())
+            pop_front();
+    }
+
+private:
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Slot;
+
+    void grow()
+    {
+        // capacity stays a power of two so that wrapping around is a bit mask
+        size_t capacity = _capacity == 0 ? 8 : 2 * _capacity;
+        std::unique_ptr<Slot[]> slots(new Slot[capacity]);
+        for (size_t i = 0; i < _size; i++)
+        {
+            new (&slots[i]) T(std::move(at(i)));
+            at(i).~T();
+        }
+        _slots = std::move(slots);
+        _capacity = capacity;
+        _head = 0;
+    }
+
+    std::unique_ptr<Slot[]> _slots;
+    size_t _capacity; // always zero or a power of two
+    size_t _head;     // index of the front element
+    size_t _size;
+};
+
+#endif
@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+#include "Vehicle.h"
+#include "Street.h"
+#include "Intersection.h"
+#include "VehicleRegistry.h"
+#include "EngineKernel.h"
+#include "NetworkGenerator.h"
+#include "Scenario.h"
+
+// Paris
+void createTrafficObjects_Paris(std::shared_ptr<SimulationContext> context, std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections, std::vector<VehiclePlacement> &placements, std::string &filename, int nVehicles)
+{
+    // assign filename of corresponding city map
+    filename = "../data/paris.jpg";
+
+    // init traffic objects
+    int nIntersections = 9;
+    for (size_t ni = 0; ni < nIntersections; ni++)
+    {
+        intersections.push_back(std::make_shared<Intersection>(context));
+    }
+
+    // position intersections in pixel coordinates (counter-clockwise)
+    intersections.at(0)->setPosition(385, 270);
+    intersections.at(1)->setPosition(1240, 80);
+    intersections.at(2)->setPosition(1625, 75);
+    intersections.at(3)->setPosition(2110, 75);
+    intersections.at(4)->setPosition(2840, 175);
+    intersections.at(5)->setPosition(3070, 680);
+    intersections.at(6)->setPosition(2800, 1400);
+    intersections.at(7)->setPosition(400, 1100);
+    intersections.at(8)->setPosition(1700, 900); // central plaza
+
+    // create streets and connect traffic objects
+    int nStreets = 8;
+    for (size_t ns = 0; ns < nStreets; ns++)
+    {
+        streets.push_back(std::make_shared<Street>(context));
+        streets.at(ns)->setLanes(context->getConfig().lanes);
+        streets.at(ns)->setInIntersection(intersections.at(ns));
+        streets.at(ns)->setOutIntersection(intersections.at(8));
+    }
+
+    // place vehicles on streets (several vehicles share a street once there are more vehicles than streets)
+    for (size_t nv = 0; nv < nVehicles; nv++)
+    {
+        placements.push_back(VehiclePlacement{static_cast<int>(nv % nStreets), 8});
+    }
+}
+
+// NYC
+void createTrafficObjects_NYC(std::shared_ptr<SimulationContext> context, std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections, std::vector<VehiclePlacement> &placements, std::string &filename, int nVehicles)
+{
+    // assign filename of corresponding city map
+    filename = "../data/nyc.jpg";
+
+    // init traffic objects
+    int nIntersections = 6;
+    for (size_t ni = 0; ni < nIntersections; ni++)
+    {
+        intersections.push_back(std::make_shared<Intersection>(context));
+    }
+
+    // position intersections in pixel coordinates
+    intersections.at(0)->setPosition(1430, 625);
+    intersections.at(1)->setPosition(2575, 1260);
+    intersections.at(2)->setPosition(2200, 1950);
+    intersections.at(3)->setPosition(1000, 1350);
+    intersections.at(4)->setPosition(400, 1000);
+    intersections.at(5)->setPosition(750, 250);
+
+    // create streets and connect traffic objects
+    int nStreets = 7;
+    for (size_t ns = 0; ns < nStreets; ns++)
+    {
+        streets.push_back(std::make_shared<Street>(context));
+        streets.at(ns)->setLanes(context->getConfig().lanes);
+    }
+
+    streets.at(0)->setInIntersection(intersections.at(0));
+    streets.at(0)->setOutIntersection(intersections.at(1));
+
+    streets.at(1)->setInIntersection(intersections.at(1));
+    streets.at(1)->setOutIntersection(intersections.at(2));
+
+    streets.at(2)->setInIntersection(intersections.at(2));
+    streets.at(2)->setOutIntersection(intersections.at(3));
+
+    streets.at(3)->setInIntersection(intersections.at(3));
+    streets.at(3)->setOutIntersection(intersections.at(4));
+
+    streets.at(4)->setInIntersection(intersections.at(4));
+    streets.at(4)->setOutIntersection(intersections.at(5));
+
+    streets.at(5)->setInIntersection(intersections.at(5));
+    streets.at(5)->setOutIntersection(intersections.at(0));
+
+    streets.at(6)->setInIntersection(intersections.at(0));
+    streets.at(6)->setOutIntersection(intersections.at(3));
+
+    // place vehicles on streets, each one driving towards the intersection the street starts from
+    for (size_t nv = 0; nv < nVehicles; nv++)
+    {
+        int street = nv % nStreets;
+        int destination = std::find(intersections.begin(), intersections.end(), streets.at(street)->getInIntersection()) - intersections.begin();
+        placements.push_back(VehiclePlacement{street, destination});
+    }
+}
+
+/* Implementation of class "Scenario" */
+
+Scenario::Scenario(const ScenarioConfig &config, bool isCreatingVehicles)
+{
+    _context = std::make_shared<SimulationContext>(config);
+    _canvasWidth = _canvasHeight = 0;
+    _isStarted = false;
+
+    // create and connect intersections and streets and place the vehicles
+    if (config.map == "nyc")
+    {
+        createTrafficObjects_NYC(_context, _streets, _intersections, _placements, _backgroundImg, config.nVehicles);
+    }
+    else if (NetworkGenerator::isGenerated(config.map))
+    {
+        // synthetic networks have no background image
+        NetworkGenerator generator(_context);
+        generator.generate(_streets, _intersections, _placements, config.nVehicles);
+        double width, height;
+        generator.getCanvasSize(width, height);
+        _canvasWidth = std::lround(width);
+        _canvasHeight = std::lround(height);
+    }
+    else
+    {
+        createTrafficObjects_Paris(_context, _streets, _intersections, _placements, _backgroundImg, config.nVehicles);
+    }
+
+    if (isCreatingVehicles)
+    {
+        _firstVehicleID = -1;
+        createVehicles();
+    }
+    else
+    {
+        // keep the ids free, so that the vehicles created later on by an engine do not collide with other traffic objects
+        _firstVehicleID = _context->reserveIDs(_placements.size());
+    }
+}
+
+Scenario::~Scenario()
+{
+    stop();
+}
+
+int Scenario::getVehicleID(size_t vehicle)
+{
+    return _firstVehicleID < 0 ? _vehicles.at(vehicle)->getID() : _firstVehicleID + static_cast<int>(vehicle);
+}
+
+const EngineNetwork &Scenario::getNetwork()
+{
+    if (!_network)
+        _network.reset(new EngineNetwork(_streets, _intersections));
+    return *_network;
+}
+
+std::vector<std::shared_ptr<TrafficObject>> Scenario::getTrafficObjects()
+{
+    // add all objects into common vector
+    std::vector<std::shared_ptr<TrafficObject>> trafficObjects;
+    std::for_each(_intersections.begin(), _intersections.end(), [&trafficObjects](std::shared_ptr<Intersection> &intersection) {
+        std::shared_ptr<TrafficObject> trafficObject = std::dynamic_pointer_cast<TrafficObject>(intersection);
+        trafficObjects.push_back(trafficObject);
+    });
+
+    std::for_each(_vehicles.begin(), _vehicles.end(), [&trafficObjects](std::shared_ptr<Vehicle> &vehicles) {
+        std::shared_ptr<TrafficObject> trafficObject = std::dynamic_pointer_cast<TrafficObject>(vehicles);
+        trafficObjects.push_back(trafficObject);
+    });
+
+    return trafficObjects;
+}
+
+void Scenario::start()
+{
+    // start the simulation of all intersections, this will spawn each intersection's vehicle queue process in a new thread
+    std::for_each(_intersections.begin(), _intersections.end(), [](std::shared_ptr<Intersection> &i) {
+        i->simulate();
+    });
+
+    // start the simulation of all vehicles, this will spawn each vehicle's drive function in a separated thread
+    std::for_each(_vehicles.begin(), _vehicles.end(), [](std::shared_ptr<Vehicle> &v) {
+        v->simulate();
+    });
+
+    _isStarted = true;
+}
+
+void Scenario::stop()
+{
+    if (!_isStarted)
+    {
+        return;
+    }
+
+    _context->stop();
+
+    // intersections have to finish first, as they release all vehicles still waiting in front of them
+    std::for_each(_intersections.begin(), _intersections.end(), [](std::shared_ptr<Intersection> &i) {
+        i->joinThreads();
+    });
+    std::for_each(_vehicles.begin(), _vehicles.end(), [](std::shared_ptr<Vehicle> &v) {
+        v->joinThreads();
+    });
+
+    _isStarted = false;
+}
+
+void Scenario::createVehicles()
+{
+    // large fleets are created on all cores, each thread filling a contiguous range of vehicles
+    VehicleFactory createVehicle = findVehicleFactory(_context->getConfig().motionModel, _context->getConfig().routingPolicy);
+    size_t nVehicles = _placements.size();
+    size_t nThreads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), nVehicles / minVehiclesPerThread));
+    _vehicles.assign(nVehicles, nullptr);
+    std::vector<std::thread> threads;
+    for (size_t nt = 0; nt < nThreads; nt++)
+    {
+        threads.emplace_back(std::thread([this, &createVehicle, nVehicles, nThreads, nt]() {
+            for (size_t nv = nVehicles * nt / nThreads; nv < nVehicles * (nt + 1) / nThreads; nv++)
+            {
+                _vehicles[nv] = createVehicle(_context);
+                _vehicles[nv]->setCurrentStreet(_streets.at(_placements[nv].street));
+                _vehicles[nv]->setCurrentDestination(_intersections.at(_placements[nv].destination));
+            }
+        }));
+    }
+    std::for_each(threads.begin(), threads.end(), [](std::thread &t) {
+        t.join();
+    });
+}
+
+SimulationStats Scenario::run()
+{
+    auto startTime = std::chrono::system_clock::now();
+    start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<long>(_context->getConfig().duration * 1000)));
+    stop();
+
+    SimulationStats stats = _context->getStats();
+    stats.runs = 1;
+    stats.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - startTime).count() / 1000.0;
+    return stats;
+}
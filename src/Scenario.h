@@ -0,0 +1,72 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "SimulationContext.h"
+
+// forward declarations to avoid include cycle
+class TrafficObject;
+class Street;
+class Intersection;
+class Vehicle;
+struct EngineNetwork;
+
+// initial street and destination of a vehicle, as indices into the streets and intersections of its scenario
+struct VehiclePlacement
+{
+    int street;
+    int destination;
+};
+
+// functions creating and connecting the intersections and streets of a city map and placing its vehicles
+void createTrafficObjects_Paris(std::shared_ptr<SimulationContext> context, std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections, std::vector<VehiclePlacement> &placements, std::string &filename, int nVehicles);
+void createTrafficObjects_NYC(std::shared_ptr<SimulationContext> context, std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections, std::vector<VehiclePlacement> &placements, std::string &filename, int nVehicles);
+
+// self-contained instance of a traffic simulation: owns its traffic objects and their shared context
+class Scenario
+{
+public:
+    // constructor / destructor
+    // throws std::invalid_argument for a malformed generated network (see NetworkGenerator.h); without isCreatingVehicles
+    // the vehicles are only placed, for engines which create their own, e.g. in the processes of a PartitionedSimulation
+    Scenario(const ScenarioConfig &config, bool isCreatingVehicles = true);
+    ~Scenario();
+
+    // getters / setters
+    std::shared_ptr<SimulationContext> getContext() { return _context; }
+    std::string getBackgroundImg() { return _backgroundImg; }
+    void getCanvasSize(int &width, int &height) { width = _canvasWidth; height = _canvasHeight; } // blank canvas drawn without a background image, 0 for city maps
+    std::vector<std::shared_ptr<TrafficObject>> getTrafficObjects(); // all intersections and vehicles, e.g. for drawing
+    const std::vector<std::shared_ptr<Street>> &getStreets() { return _streets; }
+    const std::vector<std::shared_ptr<Intersection>> &getIntersections() { return _intersections; }
+    const std::vector<std::shared_ptr<Vehicle>> &getVehicles() { return _vehicles; }
+    const std::vector<VehiclePlacement> &getVehiclePlacements() { return _placements; }
+    int getVehicleID(size_t vehicle); // id of the vehicle placed by getVehiclePlacements()[vehicle], also if it has not been created
+    const EngineNetwork &getNetwork(); // index of the streets and intersections for engines, built on the first call
+
+    // typical behaviour methods
+    void start();           // launch the threads of all intersections and vehicles
+    void stop();            // ask all threads to finish and wait for them
+    SimulationStats run();  // start, run for the configured duration, stop and return the gathered statistics
+
+private:
+    // typical behaviour methods
+    void createVehicles();
+
+    static const size_t minVehiclesPerThread = 4096; // below which more threads do not pay off
+
+    std::shared_ptr<SimulationContext> _context;
+    std::vector<std::shared_ptr<Street>> _streets;
+    std::vector<std::shared_ptr<Intersection>> _intersections;
+    std::vector<std::shared_ptr<Vehicle>> _vehicles;
+    std::vector<VehiclePlacement> _placements;
+    std::unique_ptr<EngineNetwork> _network;
+    int _firstVehicleID; // first of the ids reserved for vehicles which have not been created
+    std::string _backgroundImg;
+    int _canvasWidth, _canvasHeight;
+    bool _isStarted;
+};
+
+#endif
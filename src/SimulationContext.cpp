@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include "SimulationContext.h"
+
+/* Implementation of struct "ScenarioConfig" */
+
+std::string ScenarioConfig::getLabel() const
+{
+    std::ostringstream label;
+    label << map << " vehicles=" << nVehicles << " cycle=" << minCycleDuration << "-" << maxCycleDuration << "ms"
+          << " lanes=" << lanes << " model=" << motionModel << "/" << routingPolicy;
+    if (isEventDriven)
+        label << " events";
+    return label.str();
+}
+
+/* Implementation of struct "SimulationStats" */
+
+void SimulationStats::merge(const SimulationStats &other)
+{
+    runs += other.runs;
+    crossings += other.crossings;
+    totalWaitTime += other.totalWaitTime;
+    maxWaitTime = std::max(maxWaitTime, other.maxWaitTime);
+    duration += other.duration;
+}
+
+/* Implementation of class "SimulationContext" */
+
+SimulationContext::SimulationContext(const ScenarioConfig &config) : _config(config)
+{
+    _idCnt = 0;
+    _seedCnt = 0;
+    _isRunning = true;
+}
+
+unsigned int SimulationContext::nextSeed()
+{
+    if (_config.seed == 0)
+    {
+        // construct a time-based seed as the simulation did before seeds became configurable
+        return std::chrono::system_clock::now().time_since_epoch().count() + _seedCnt++;
+    }
+    return _config.seed + _seedCnt++;
+}
+
+unsigned int SimulationContext::reserveSeeds(unsigned int n)
+{
+    if (_config.seed == 0)
+        return std::chrono::system_clock::now().time_since_epoch().count() + _seedCnt.fetch_add(n);
+    return _config.seed + _seedCnt.fetch_add(n);
+}
+
+void SimulationContext::recordCrossing(double waitTime)
+{
+    std::lock_guard<std::mutex> lock(_statsMtx);
+    _stats.crossings++;
+    _stats.totalWaitTime += waitTime;
+    _stats.maxWaitTime = std::max(_stats.maxWaitTime, waitTime);
+}
+
+SimulationStats SimulationContext::getStats()
+{
+    std::lock_guard<std::mutex> lock(_statsMtx);
+    return _stats;
+}
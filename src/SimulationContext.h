@@ -0,0 +1,78 @@
+#ifndef SIMULATIONCONTEXT_H
+#define SIMULATIONCONTEXT_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+// parameters describing a single scenario instance
+struct ScenarioConfig
+{
+    std::string map = "paris";             // name of the city map used to create the traffic objects, or a generated network like "grid:1000"
+    int nVehicles = 6;                     // number of vehicles placed on the streets initially
+    int minCycleDuration = 4000;           // lower bound of the traffic light cycle duration in ms
+    int maxCycleDuration = 6000;           // upper bound of the traffic light cycle duration in ms
+    int platoonSize = 8;                   // maximum number of vehicles per lane released in one batch at green
+    int saturationHeadway = 100;           // time between two vehicles of a platoon on the same lane in ms
+    int lanes = 1;                         // number of lanes per driving direction on every street
+    double vehicleSpeed = 400;             // vehicle cruising speed in m/s
+    std::string motionModel = "constant";  // name of the compiled motion model (see VehiclePolicies.h)
+    std::string routingPolicy = "random";  // name of the compiled routing policy (see VehiclePolicies.h)
+    double duration = 10.0;                // simulated time in s (only used when the scenario is not run interactively)
+    unsigned int seed = 0;                 // seed for all random generators, 0 means time-based
+    bool isVerbose = true;                 // print thread and vehicle messages to cout
+    bool isEventDriven = false;            // run SimulationEngine in its discrete-event mode instead of fixed steps
+    double minStreetLength = 1000.0;       // lower bound of the street length of generated networks in m
+    double maxStreetLength = 1000.0;       // upper bound of the street length of generated networks in m
+    double meanDegree = 0.0;               // mean number of streets per intersection of generated networks, 0 keeps all candidate streets
+
+    std::string getLabel() const; // human readable summary of the swept parameters
+};
+
+// statistics gathered while a scenario is running
+struct SimulationStats
+{
+    int runs = 0;               // number of scenario runs merged into these statistics
+    long crossings = 0;         // number of vehicles that have been granted entry to an intersection
+    double totalWaitTime = 0.0; // accumulated time vehicles spent waiting at intersections in ms
+    double maxWaitTime = 0.0;   // longest single wait at an intersection in ms
+    double duration = 0.0;      // accumulated wall-clock duration of all runs in s
+
+    void merge(const SimulationStats &other);
+    double getThroughput() const { return duration > 0.0 ? crossings / duration : 0.0; }
+    double getMeanWaitTime() const { return crossings > 0 ? totalWaitTime / crossings : 0.0; }
+};
+
+// state shared by all traffic objects of one scenario, so that several scenarios can live in the same process
+class SimulationContext
+{
+public:
+    // constructor / destructor
+    SimulationContext(const ScenarioConfig &config);
+
+    // getters / setters
+    const ScenarioConfig &getConfig() const { return _config; }
+    bool isRunning() const { return _isRunning; }
+    bool isVerbose() const { return _config.isVerbose; }
+    std::mutex &getCoutMutex() { return _coutMtx; }
+    SimulationStats getStats();
+
+    // typical behaviour methods
+    int nextID() { return _idCnt++; }
+    int reserveIDs(int n) { return _idCnt.fetch_add(n); } // first of n consecutive ids
+    unsigned int nextSeed();
+    unsigned int reserveSeeds(unsigned int n); // first of n consecutive seeds
+    void recordCrossing(double waitTime);
+    void stop() { _isRunning = false; }
+
+private:
+    const ScenarioConfig _config;
+    std::atomic<int> _idCnt;            // counter for object ids within this scenario
+    std::atomic<unsigned int> _seedCnt; // counter used to derive a distinct seed for each random generator
+    std::atomic<bool> _isRunning;       // cleared when the scenario is asked to shut down
+    std::mutex _coutMtx;                // mutex shared by all traffic objects of this scenario for protecting cout
+    std::mutex _statsMtx;               // protects _stats
+    SimulationStats _stats;
+};
+
+#endif
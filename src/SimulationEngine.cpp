@@ -0,0 +1,528 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "Street.h"
+#include "Intersection.h"
+#include "Scenario.h"
+#include "VehicleRegistry.h"
+#include "Profiler.h"
+#include "SimulationEngine.h"
+
+/* Implementation of class "SimulationEngine" */
+
+SimulationEngine::SimulationEngine(Scenario &scenario, const std::vector<bool> &isOwned)
+    : _context(scenario.getContext()), _network(scenario.getNetwork()), _stepCnt(0), _eventCnt(0)
+{
+    const ScenarioConfig &config = _context->getConfig();
+    _isEventDriven = config.isEventDriven;
+    _kernel = findVehicleModel(config.motionModel, config.routingPolicy).kernelFactory(_network);
+    _cycleDistribution = std::uniform_int_distribution<int>(config.minCycleDuration, config.maxCycleDuration);
+    _headwaySteps = std::lround(config.saturationHeadway / 1000.0 / stepDuration);
+
+    // seeds are reserved for all intersections and vehicles of the scenario, so that every light and vehicle
+    // gets the same seed no matter how the intersections are split between partitions
+    unsigned int firstLightSeed = _context->reserveSeeds(_network.intersections.size());
+
+    // every light starts red with its own random cycle, like TrafficLight::cycleThroughPhases();
+    // intersections owned by other partitions get no state here, only an entry telling that they are not owned
+    for (size_t ni = 0; ni < _network.intersections.size(); ni++)
+    {
+        if (!isOwned.empty() && (ni >= isOwned.size() || !isOwned[ni]))
+        {
+            _ownedIndex.push_back(-1);
+            continue;
+        }
+        int owned = _intersections.size();
+        _ownedIndex.push_back(owned);
+        const std::shared_ptr<Intersection> &intersection = _network.intersections[ni];
+        _lightGenerators.emplace_back(firstLightSeed + ni);
+
+        IntersectionState state{};
+        state.id = intersection->getID();
+        intersection->getPosition(state.x, state.y);
+        state.phase = TrafficLightPhase::red;
+        state.cycleDuration = nextCycleDuration(owned);
+        _intersections.push_back(state);
+
+        ConflictMatrix conflicts;
+        std::vector<int> lanes;
+        intersection->getLayout(conflicts, lanes);
+        _queues.emplace_back();
+        _queues.back().setLayout(conflicts, lanes);
+        _dischargeEnd.push_back(0.0);
+
+        _lightGenerations.push_back(0);
+        _phaseStarts.push_back(0.0);
+        _blockedVehicles.emplace_back();
+        if (_isEventDriven)
+            schedule(state.cycleDuration, eventLightChange, owned);
+    }
+
+    // create the vehicles where the scenario has placed them, vehicles heading for other partitions are simulated there
+    const std::vector<VehiclePlacement> &placements = scenario.getVehiclePlacements();
+    unsigned int firstVehicleSeed = _context->reserveSeeds(placements.size());
+    for (size_t nv = 0; nv < placements.size(); nv++)
+    {
+        if (_ownedIndex[placements[nv].destination] >= 0)
+            addVehicle(scenario.getVehicleID(nv), placements[nv].street, placements[nv].destination, 0.0, config.vehicleSpeed, firstVehicleSeed + nv, 0.0);
+    }
+}
+
+StateView<VehicleState> SimulationEngine::getVehicles()
+{
+    if (_isEventDriven)
+        interpolatePositions();
+    return StateView<VehicleState>(_vehicles.data(), _vehicles.size());
+}
+
+StateView<IntersectionState> SimulationEngine::getIntersections()
+{
+    if (_isEventDriven)
+    {
+        for (size_t ni = 0; ni < _intersections.size(); ni++)
+        {
+            _intersections[ni].phaseTime = getTime() - _phaseStarts[ni];
+        }
+    }
+    return StateView<IntersectionState>(_intersections.data(), _intersections.size());
+}
+
+SimulationStats SimulationEngine::getStats()
+{
+    SimulationStats stats = _context->getStats();
+    stats.runs = 1;
+    stats.duration = getTime();
+    return stats;
+}
+
+double SimulationEngine::getTravelTime(int street)
+{
+    VehicleState probe{};
+    probe.status = vehicleDriving;
+    probe.street = street;
+    probe.speed = _context->getConfig().vehicleSpeed;
+    return _kernel->getTravelTime(probe, 0.9);
+}
+
+void SimulationEngine::addVehicle(int id, int street, int destination, double posStreet, double speed, unsigned int seed, double time)
+{
+    VehicleState vehicle{};
+    vehicle.id = id;
+    vehicle.speed = speed;
+    placeVehicle(vehicle, street, destination, posStreet, time);
+
+    size_t index = _vehicles.size();
+    if (_freeSlots.empty())
+    {
+        _vehicles.push_back(vehicle);
+    }
+    else
+    {
+        index = _freeSlots.back();
+        _freeSlots.pop_back();
+        _vehicles[index] = vehicle;
+    }
+    _kernel->seedVehicle(index, seed);
+
+    if (_isEventDriven)
+        schedule(time + std::max(0.0, _kernel->getTravelTime(vehicle, 0.9)), eventArrival, index);
+    else if (time < getTime())
+        _kernel->moveBy(_vehicles[index], getTime() - time); // catch up on the steps since the vehicle has entered its street
+}
+
+std::vector<VehicleHandoff> SimulationEngine::takeHandoffs()
+{
+    std::vector<VehicleHandoff> handoffs;
+    handoffs.swap(_handoffs);
+    return handoffs;
+}
+
+void SimulationEngine::acceptVehicle(const VehicleHandoff &handoff)
+{
+    addVehicle(handoff.id, handoff.street, handoff.destination, 0.0, handoff.speed, handoff.seed, handoff.time);
+}
+
+bool SimulationEngine::handOff(size_t vehicle, int street, int destination, double time)
+{
+    if (_ownedIndex[destination] >= 0)
+        return false;
+
+    VehicleState &state = _vehicles[vehicle];
+    _handoffs.push_back(VehicleHandoff{state.id, street, destination, _context->nextSeed(), state.speed, time});
+    state.status = vehicleInactive;
+    _freeSlots.push_back(vehicle);
+    return true;
+}
+
+void SimulationEngine::placeVehicle(VehicleState &vehicle, int street, int destination, double posStreet, double time)
+{
+    const std::shared_ptr<Street> &s = _network.streets[street];
+    vehicle.status = vehicleDriving;
+    vehicle.street = street;
+    vehicle.destination = destination;
+    vehicle.nextStreet = -1;
+    vehicle.isForward = _network.streetOuts[street] == destination;
+    vehicle.segment = vehicle.isForward ? 0 : std::numeric_limits<size_t>::max();
+    vehicle.posStreet = posStreet;
+    vehicle.completion = posStreet / s->getLength();
+    vehicle.updateTime = time;
+    s->getGeometry().getPosition(vehicle.posStreet, vehicle.isForward, vehicle.segment, vehicle.x, vehicle.y);
+}
+
+double SimulationEngine::nextCycleDuration(int intersection)
+{
+    return _cycleDistribution(_lightGenerators[intersection]) / 1000.0;
+}
+
+void SimulationEngine::submit(const CommandBuffer &commands)
+{
+    submit(commands.getCommands().data(), commands.size());
+}
+
+void SimulationEngine::submit(const Command *commands, size_t nCommands)
+{
+    // reject the whole batch before anything is queued, so that a controller never sees half of it applied
+    for (size_t nc = 0; nc < nCommands; nc++)
+    {
+        const Command &command = commands[nc];
+        switch (command.type)
+        {
+        case commandSetPhase:
+        case commandReleasePhase:
+            if (command.target < 0 || command.target >= static_cast<int>(_ownedIndex.size()))
+                throw std::out_of_range("no intersection with index " + std::to_string(command.target));
+            if (_ownedIndex[command.target] < 0)
+                throw std::out_of_range("intersection " + std::to_string(command.target) + " is simulated by another partition");
+            break;
+        case commandInjectVehicle:
+        {
+            if (command.target < 0 || command.target >= static_cast<int>(_network.streets.size()))
+                throw std::out_of_range("no street with index " + std::to_string(command.target));
+            if (command.value != _network.streetIns[command.target] && command.value != _network.streetOuts[command.target])
+                throw std::out_of_range("intersection " + std::to_string(command.value) + " is not an end of street " + std::to_string(command.target));
+            break;
+        }
+        default:
+            throw std::out_of_range("unknown command type " + std::to_string(command.type));
+        }
+    }
+    _pendingCommands.insert(_pendingCommands.end(), commands, commands + nCommands);
+}
+
+void SimulationEngine::step(long nSteps)
+{
+    if (_isEventDriven)
+    {
+        // jump from event to event, commands take effect at the current time
+        PROFILE_ZONE("SimulationEngine::processEvents");
+        double endTime = (_stepCnt + nSteps) * stepDuration;
+        applyCommands();
+        while (!_events.empty() && _events.top().time <= endTime)
+        {
+            Event event = _events.top();
+            _events.pop();
+            processEvent(event);
+        }
+        _stepCnt += nSteps;
+        return;
+    }
+
+    for (long n = 0; n < nSteps; n++)
+    {
+        PROFILE_ZONE("SimulationEngine::step");
+        applyCommands();
+        updateLights();
+        _kernel->advance(_vehicles, stepDuration);
+        updateVehicles();
+        admitVehicles();
+        _stepCnt++;
+    }
+}
+
+void SimulationEngine::applyCommands()
+{
+    for (auto &command : _pendingCommands)
+    {
+        switch (command.type)
+        {
+        case commandSetPhase:
+        {
+            int owned = _ownedIndex[command.target];
+            IntersectionState &intersection = _intersections[owned];
+            TrafficLightPhase phase = static_cast<TrafficLightPhase>(command.value);
+            intersection.isExternallyControlled = true;
+            intersection.cycleDuration = 0.0;
+            _lightGenerations[owned]++; // cancels the pending light change of the own cycle
+            if (intersection.phase != phase)
+            {
+                if (_isEventDriven)
+                {
+                    changeLight(owned, phase, getTime());
+                }
+                else
+                {
+                    intersection.phase = phase;
+                    intersection.phaseTime = 0.0;
+                }
+            }
+            break;
+        }
+        case commandReleasePhase:
+        {
+            int owned = _ownedIndex[command.target];
+            IntersectionState &intersection = _intersections[owned];
+            if (intersection.isExternallyControlled)
+            {
+                intersection.isExternallyControlled = false;
+                intersection.phaseTime = 0.0;
+                intersection.cycleDuration = nextCycleDuration(owned);
+                _phaseStarts[owned] = getTime();
+                if (_isEventDriven)
+                    schedule(getTime() + intersection.cycleDuration, eventLightChange, owned, _lightGenerations[owned]);
+            }
+            break;
+        }
+        case commandInjectVehicle:
+            if (_ownedIndex[command.value] >= 0)
+                addVehicle(_context->nextID(), command.target, command.value, command.position, _context->getConfig().vehicleSpeed, _context->nextSeed(), getTime());
+            else
+                _handoffs.push_back(VehicleHandoff{_context->nextID(), command.target, command.value, _context->nextSeed(), _context->getConfig().vehicleSpeed, getTime()});
+            break;
+        }
+    }
+    _pendingCommands.clear();
+}
+
+void SimulationEngine::updateLights()
+{
+    for (size_t ni = 0; ni < _intersections.size(); ni++)
+    {
+        IntersectionState &intersection = _intersections[ni];
+        intersection.phaseTime += stepDuration;
+        if (!intersection.isExternallyControlled && intersection.phaseTime > intersection.cycleDuration)
+        {
+            intersection.phase = intersection.phase == TrafficLightPhase::red ? TrafficLightPhase::green : TrafficLightPhase::red;
+            intersection.phaseTime = 0.0;
+            intersection.cycleDuration = nextCycleDuration(ni);
+        }
+    }
+}
+
+void SimulationEngine::updateVehicles()
+{
+    for (size_t nv = 0; nv < _vehicles.size(); nv++)
+    {
+        VehicleState &vehicle = _vehicles[nv];
+        switch (vehicle.status)
+        {
+        case vehicleArrived:
+        {
+            // queue up for the movement from the current to the chosen street
+            const std::shared_ptr<Intersection> &destination = _network.intersections[vehicle.destination];
+            int fromLeg = destination->getLeg(_network.streets[vehicle.street]);
+            int toLeg = destination->getLeg(_network.streets[vehicle.nextStreet]);
+            _queues[_ownedIndex[vehicle.destination]].push(vehicle.id, nv, fromLeg, toLeg);
+            vehicle.status = vehicleWaiting;
+            vehicle.queuedTime = getTime();
+            break;
+        }
+        case vehiclePermitted:
+            // like Intersection::addVehicleToQueue(), a permitted vehicle still waits for green
+            if (_stepCnt >= std::lround(vehicle.releaseTime / stepDuration) && _intersections[_ownedIndex[vehicle.destination]].phase == TrafficLightPhase::green)
+            {
+                vehicle.status = vehicleCrossing;
+                _context->recordCrossing((getTime() - vehicle.queuedTime) * 1000.0);
+            }
+            break;
+        case vehicleCrossing:
+            if (vehicle.completion >= 1.0)
+            {
+                // release the movement and continue on the chosen street towards its other end
+                _queues[_ownedIndex[vehicle.destination]].release(vehicle.id);
+                // the vehicle stands at the start of the street at the end of this step, so a partition taking it
+                // over has to move it along for the steps after this one only
+                int nextIntersection = _network.getOtherEnd(vehicle.nextStreet, vehicle.destination);
+                if (!handOff(nv, vehicle.nextStreet, nextIntersection, getTime() + stepDuration))
+                    placeVehicle(vehicle, vehicle.nextStreet, nextIntersection, 0.0, getTime());
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void SimulationEngine::admitVehicles()
+{
+    const int platoonSize = _context->getConfig().platoonSize;
+    for (size_t ni = 0; ni < _intersections.size(); ni++)
+    {
+        IntersectionState &intersection = _intersections[ni];
+
+        // a new platoon is formed once the previous one has been released, as in Intersection::processVehicleQueue()
+        if (_queues[ni].getSize() > 0 && intersection.phase == TrafficLightPhase::green && _stepCnt >= std::lround(_dischargeEnd[ni] / stepDuration))
+        {
+            long lastRelease = _stepCnt;
+            _queues[ni].popPlatoons(platoonSize, [this, &lastRelease](int vehicle, int slot) {
+                _vehicles[vehicle].status = vehiclePermitted;
+                _vehicles[vehicle].releaseTime = (_stepCnt + slot * _headwaySteps) * stepDuration;
+                lastRelease = std::max(lastRelease, _stepCnt + slot * _headwaySteps);
+            });
+            _dischargeEnd[ni] = (lastRelease + 1) * stepDuration;
+        }
+        intersection.queueLength = _queues[ni].getSize();
+        intersection.activeVehicles = _queues[ni].getNumActive();
+    }
+}
+
+void SimulationEngine::schedule(double time, EventType type, int target, long generation)
+{
+    // every event scheduled so far has either been processed or is still queued, so this numbers them in order
+    int key = type == eventLightChange || type == eventDischargeEnd ? _intersections[target].id : _vehicles[target].id;
+    _events.push(Event{time, type, key, _eventCnt + static_cast<long>(_events.size()), target, generation});
+}
+
+void SimulationEngine::processEvent(const Event &event)
+{
+    _eventCnt++;
+    switch (event.type)
+    {
+    case eventArrival:
+    {
+        // the vehicle has not been looked at since it entered its street
+        VehicleState &vehicle = _vehicles[event.target];
+        _kernel->moveBy(vehicle, event.time - vehicle.updateTime);
+        vehicle.updateTime = event.time;
+        _kernel->route(_vehicles, event.target);
+        queueVehicle(event.target, event.time);
+        break;
+    }
+    case eventRelease:
+    {
+        // like Intersection::addVehicleToQueue(), a permitted vehicle still waits for green
+        VehicleState &vehicle = _vehicles[event.target];
+        int owned = _ownedIndex[vehicle.destination];
+        if (_intersections[owned].phase == TrafficLightPhase::green)
+            enterIntersection(event.target, event.time);
+        else
+            _blockedVehicles[owned].push_back(event.target);
+        break;
+    }
+    case eventExit:
+        leaveIntersection(event.target, event.time);
+        break;
+    case eventLightChange:
+    {
+        // a phase command has taken over the light since this change was scheduled
+        if (event.generation != _lightGenerations[event.target])
+            break;
+        IntersectionState &intersection = _intersections[event.target];
+        changeLight(event.target, intersection.phase == TrafficLightPhase::red ? TrafficLightPhase::green : TrafficLightPhase::red, event.time);
+        intersection.cycleDuration = nextCycleDuration(event.target);
+        schedule(event.time + intersection.cycleDuration, eventLightChange, event.target, event.generation);
+        break;
+    }
+    case eventDischargeEnd:
+        dischargePlatoons(event.target, event.time);
+        break;
+    }
+}
+
+void SimulationEngine::queueVehicle(size_t vehicle, double time)
+{
+    VehicleState &state = _vehicles[vehicle];
+    const std::shared_ptr<Intersection> &destination = _network.intersections[state.destination];
+    int fromLeg = destination->getLeg(_network.streets[state.street]);
+    int toLeg = destination->getLeg(_network.streets[state.nextStreet]);
+    int owned = _ownedIndex[state.destination];
+    _queues[owned].push(state.id, vehicle, fromLeg, toLeg);
+    state.status = vehicleWaiting;
+    state.queuedTime = time;
+    dischargePlatoons(owned, time);
+}
+
+void SimulationEngine::enterIntersection(size_t vehicle, double time)
+{
+    // the vehicle has been standing at the halting position, so its position is still up to date
+    VehicleState &state = _vehicles[vehicle];
+    state.status = vehicleCrossing;
+    state.updateTime = time;
+    _context->recordCrossing((time - state.queuedTime) * 1000.0);
+    schedule(time + std::max(0.0, _kernel->getTravelTime(state, 1.0)), eventExit, vehicle);
+}
+
+void SimulationEngine::leaveIntersection(size_t vehicle, double time)
+{
+    // release the movement and continue on the chosen street towards its other end
+    VehicleState &state = _vehicles[vehicle];
+    int intersection = _ownedIndex[state.destination];
+    _queues[intersection].release(state.id);
+    int nextIntersection = _network.getOtherEnd(state.nextStreet, state.destination);
+    if (!handOff(vehicle, state.nextStreet, nextIntersection, time))
+    {
+        placeVehicle(state, state.nextStreet, nextIntersection, 0.0, time);
+        schedule(time + std::max(0.0, _kernel->getTravelTime(state, 0.9)), eventArrival, vehicle);
+    }
+
+    // the freed movement may let the next platoon in
+    dischargePlatoons(intersection, time);
+}
+
+void SimulationEngine::changeLight(int intersection, TrafficLightPhase phase, double time)
+{
+    IntersectionState &state = _intersections[intersection];
+    state.phase = phase;
+    _phaseStarts[intersection] = time;
+    if (phase != TrafficLightPhase::green)
+        return;
+
+    // let in the vehicles whose slot has passed during red, then the next platoon
+    for (int vehicle : _blockedVehicles[intersection])
+    {
+        enterIntersection(vehicle, time);
+    }
+    _blockedVehicles[intersection].clear();
+    dischargePlatoons(intersection, time);
+}
+
+void SimulationEngine::dischargePlatoons(int intersection, double time)
+{
+    IntersectionState &state = _intersections[intersection];
+
+    // a new platoon is formed once the previous one has been released, as in the stepped mode
+    if (_queues[intersection].getSize() > 0 && state.phase == TrafficLightPhase::green && time >= _dischargeEnd[intersection])
+    {
+        double headway = _headwaySteps * stepDuration;
+        double lastRelease = time;
+        int nPermitted = _queues[intersection].popPlatoons(_context->getConfig().platoonSize, [this, time, headway, &lastRelease](int vehicle, int slot) {
+            _vehicles[vehicle].status = vehiclePermitted;
+            _vehicles[vehicle].releaseTime = time + slot * headway;
+            lastRelease = std::max(lastRelease, _vehicles[vehicle].releaseTime);
+            schedule(_vehicles[vehicle].releaseTime, eventRelease, vehicle);
+        });
+        if (nPermitted > 0)
+        {
+            _dischargeEnd[intersection] = lastRelease + stepDuration;
+            schedule(_dischargeEnd[intersection], eventDischargeEnd, intersection);
+        }
+    }
+    state.queueLength = _queues[intersection].getSize();
+    state.activeVehicles = _queues[intersection].getNumActive();
+}
+
+void SimulationEngine::interpolatePositions()
+{
+    // only vehicles which are moving and have not been looked at in this step are touched
+    double time = getTime();
+    for (auto &vehicle : _vehicles)
+    {
+        if ((vehicle.status == vehicleDriving || vehicle.status == vehicleCrossing) && vehicle.updateTime < time)
+        {
+            _kernel->moveBy(vehicle, time - vehicle.updateTime);
+            vehicle.updateTime = time;
+        }
+    }
+}
@@ -0,0 +1,129 @@
+#ifndef SIMULATIONENGINE_H
+#define SIMULATIONENGINE_H
+
+#include <functional>
+#include <memory>
+#include <queue>
+#include <random>
+#include <tuple>
+#include <vector>
+#include "SimulationContext.h"
+#include "EngineState.h"
+#include "EngineKernel.h"
+#include "MovementQueues.h"
+
+// forward declarations to avoid include cycle
+class Scenario;
+
+// Single-threaded, explicitly stepped simulation of a scenario for embedding into a controller or co-simulation.
+// It takes the street network, the vehicle placements and the configuration of a scenario which has not been started, and
+// advances them in fixed steps of stepDuration with the same motion models, routing policies, movement queues
+// and platoon discharge as the threaded simulation. State is read through views on the engine's own arrays.
+//
+// With ScenarioConfig::isEventDriven the engine is mesoscopic: instead of moving every vehicle in every step,
+// it computes when a vehicle reaches its halting position or leaves an intersection and only touches it then.
+// Between events, positions are interpolated when the vehicle view is requested, so the cost of step() scales
+// with the number of events rather than with vehicles x steps.
+//
+// An engine may own only some of the intersections, as one partition of a PartitionedSimulation. Vehicles
+// leaving towards an intersection owned by another partition are then handed off instead of being simulated,
+// and lights, queues and intersection states are only kept for the owned intersections. Vehicles, handoffs and
+// commands refer to intersections by their index in the scenario, the intersection view lists the owned ones
+// in the same order, so for an engine owning all intersections its index is the scenario index as well.
+class SimulationEngine
+{
+public:
+    static constexpr double stepDuration = 0.001; // simulated time per step in s, the cycle of VehicleModel::drive()
+
+    // constructor / destructor
+    SimulationEngine(Scenario &scenario, const std::vector<bool> &isOwned = std::vector<bool>()); // empty: own all intersections
+    SimulationEngine(const SimulationEngine &) = delete; // the kernel keeps the routing state of the vehicles, an engine is not duplicated
+    SimulationEngine(SimulationEngine &&) = delete;
+    SimulationEngine &operator=(const SimulationEngine &) = delete;
+    SimulationEngine &operator=(SimulationEngine &&) = delete;
+
+    // getters / setters
+    StateView<VehicleState> getVehicles();           // in the discrete-event mode, positions are interpolated to the current time first
+    StateView<IntersectionState> getIntersections(); // owned intersections only
+    long getStepCount() const { return _stepCnt; }
+    double getTime() const { return _stepCnt * stepDuration; }
+    long getEventCount() const { return _eventCnt; } // events processed so far in the discrete-event mode
+    SimulationStats getStats(); // crossings recorded so far, duration is the simulated time
+    double getTravelTime(int street); // free-flow time from entering the street to the halting position in s
+
+    // typical behaviour methods
+    void submit(const CommandBuffer &commands);                  // queue commands for the next step, throws std::out_of_range for invalid or not owned targets
+    void submit(const Command *commands, size_t nCommands);
+    void step(long nSteps = 1);
+    std::vector<VehicleHandoff> takeHandoffs();      // vehicles which have left towards intersections owned elsewhere
+    void acceptVehicle(const VehicleHandoff &handoff); // take over a vehicle from another partition, handoff.time must not lie ahead
+
+private:
+    enum EventType
+    {
+        eventArrival,      // vehicle reaches the halting position in front of its destination
+        eventRelease,      // slot of a permitted vehicle within its platoon has come
+        eventExit,         // vehicle has crossed the intersection
+        eventLightChange,  // light cycle of an intersection ends
+        eventDischargeEnd, // intersection may form its next platoon
+    };
+
+    struct Event
+    {
+        double time;
+        EventType type;
+        int key;         // id of the vehicle or intersection, orders simultaneous events the same way however the intersections are partitioned
+        long sequence;   // order of scheduling, for simultaneous events of the same vehicle or intersection
+        int target;      // vehicle index or index among the owned intersections
+        long generation; // light changes scheduled before a phase command are outdated
+
+        bool operator>(const Event &other) const { return std::tie(time, type, key, sequence) > std::tie(other.time, other.type, other.key, other.sequence); }
+    };
+
+    // typical behaviour methods, intersections are addressed by their index in the scenario for vehicles
+    // and by their index among the owned intersections for the per-intersection state
+    void addVehicle(int id, int street, int destination, double posStreet, double speed, unsigned int seed, double time);
+    void placeVehicle(VehicleState &vehicle, int street, int destination, double posStreet, double time);
+    bool handOff(size_t vehicle, int street, int destination, double time); // true if destination is owned elsewhere
+    void applyCommands();
+    void updateLights();
+    void updateVehicles();
+    void admitVehicles();
+    double nextCycleDuration(int intersection);
+
+    // discrete-event mode
+    void schedule(double time, EventType type, int target, long generation = 0);
+    void processEvent(const Event &event);
+    void queueVehicle(size_t vehicle, double time);
+    void enterIntersection(size_t vehicle, double time);
+    void leaveIntersection(size_t vehicle, double time);
+    void changeLight(int intersection, TrafficLightPhase phase, double time);
+    void dischargePlatoons(int intersection, double time);
+    void interpolatePositions();
+
+    std::shared_ptr<SimulationContext> _context;
+    const EngineNetwork &_network;                     // of the scenario, which outlives the engine
+    std::unique_ptr<EngineKernel> _kernel;             // compiled for the configured motion model and routing policy
+    std::vector<VehicleState> _vehicles;
+    std::vector<int> _ownedIndex;                      // index among the owned intersections of every intersection of the scenario, -1 if owned elsewhere
+    std::vector<IntersectionState> _intersections;     // this and all other per-intersection arrays hold the owned intersections only
+    std::vector<MovementQueues<int>> _queues;          // vehicle indices waiting in front of each intersection
+    std::vector<double> _dischargeEnd;                 // time at which each intersection may form its next platoon in s
+    std::vector<std::default_random_engine> _lightGenerators;
+    std::uniform_int_distribution<int> _cycleDistribution; // cycle duration in ms
+    std::vector<Command> _pendingCommands;
+    long _headwaySteps;                                // saturation headway in steps
+    long _stepCnt;
+    std::vector<size_t> _freeSlots;                    // slots of handed off vehicles
+    std::vector<VehicleHandoff> _handoffs;
+
+    // discrete-event mode
+    bool _isEventDriven;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> _events;
+    std::vector<long> _lightGenerations;               // incremented whenever a command overrides the light cycle
+    std::vector<double> _phaseStarts;                  // time of the last phase change of each intersection in s
+    std::vector<std::vector<int>> _blockedVehicles;    // permitted vehicles of each intersection waiting for green
+    long _eventCnt;
+};
+
+#endif
@@ -4,20 +4,65 @@
 #include "Street.h"
 
 
-Street::Street()
+Street::Street(std::shared_ptr<SimulationContext> context) : TrafficObject(context)
 {
     _type = ObjectType::objectStreet;
     _length = 1000.0; // in m
+    _lanes = 1;
+    _geometry.setLength(_length);
+}
+
+void Street::setLength(double length)
+{
+    _length = length;
+    _geometry.setLength(_length);
+}
+
+void Street::setMetersPerPixel(double metersPerPixel)
+{
+    setLength(_geometry.getPixelLength() * metersPerPixel);
+}
+
+void Street::addWaypoint(double x, double y)
+{
+    _waypointsX.push_back(x);
+    _waypointsY.push_back(y);
+    updateGeometry();
 }
 
 void Street::setInIntersection(std::shared_ptr<Intersection> in)
 {
     _interIn = in;
     in->addStreet(get_shared_this()); // add this street to list of streets connected to the intersection
+    updateGeometry();
 }
 
 void Street::setOutIntersection(std::shared_ptr<Intersection> out)
 {
     _interOut = out;
     out->addStreet(get_shared_this()); // add this street to list of streets connected to the intersection
+    updateGeometry();
+}
+
+void Street::updateGeometry()
+{
+    // the shape is only known once both ends are connected
+    if (!_interIn || !_interOut)
+    {
+        return;
+    }
+
+    // corner points in driving order 'in' -> waypoints -> 'out'
+    std::vector<double> xs, ys;
+    double x, y;
+    _interIn->getPosition(x, y);
+    xs.push_back(x);
+    ys.push_back(y);
+    xs.insert(xs.end(), _waypointsX.begin(), _waypointsX.end());
+    ys.insert(ys.end(), _waypointsY.begin(), _waypointsY.end());
+    _interOut->getPosition(x, y);
+    xs.push_back(x);
+    ys.push_back(y);
+
+    _geometry.setPolyline(xs, ys);
 }
@@ -1,7 +1,9 @@
 #ifndef STREET_H
 #define STREET_H
 
+#include <vector>
 #include "TrafficObject.h"
+#include "StreetGeometry.h"
 
 // forward declaration to avoid include cycle
 class Intersection;
@@ -10,10 +12,16 @@ class Street : public TrafficObject, public std::enable_shared_from_this<Street>
 {
 public:
     // constructor / desctructor
-    Street();
+    Street(std::shared_ptr<SimulationContext> context);
 
     // getters / setters
     double getLength() { return _length; }
+    void setLength(double length);
+    int getLanes() { return _lanes; }
+    void setLanes(int lanes) { _lanes = lanes; } // number of lanes in each driving direction
+    void setMetersPerPixel(double metersPerPixel); // derive the length in m from the drawn shape of the street
+    void addWaypoint(double x, double y);          // add a corner point between 'in' and 'out' to model a curved street
+    const StreetGeometry &getGeometry() { return _geometry; }
     void setInIntersection(std::shared_ptr<Intersection> in);
     void setOutIntersection(std::shared_ptr<Intersection> out);
     std::shared_ptr<Intersection> getOutIntersection() { return _interOut; }
@@ -25,8 +33,14 @@ public:
     std::shared_ptr<Street> get_shared_this() { return shared_from_this(); }
 
 private:
+    // typical behaviour methods
+    void updateGeometry();
+
     double _length;                                    // length of this street in m
+    int _lanes;                                        // number of lanes in each driving direction
     std::shared_ptr<Intersection> _interIn, _interOut; // intersections from which a vehicle can enter (one-way streets is always from 'in' to 'out')
+    std::vector<double> _waypointsX, _waypointsY;      // corner points between 'in' and 'out' in pixels
+    StreetGeometry _geometry;                          // polyline through all corner points, rebuilt whenever one of them changes
 };
 
 #endif
\ No newline at end of file
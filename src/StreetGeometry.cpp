@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "StreetGeometry.h"
+
+StreetGeometry::StreetGeometry()
+{
+    _pixelLength = 0.0;
+    _pixelsPerMeter = 0.0;
+    _length = 0.0;
+}
+
+void StreetGeometry::setPolyline(const std::vector<double> &xs, const std::vector<double> &ys)
+{
+    _segments.clear();
+    _pixelLength = 0.0;
+
+    // one segment between each pair of consecutive corner points, with its cumulative arc length
+    for (size_t i = 0; i + 1 < xs.size(); i++)
+    {
+        Segment segment;
+        segment.x = xs.at(i);
+        segment.y = ys.at(i);
+        double dx = xs.at(i + 1) - xs.at(i);
+        double dy = ys.at(i + 1) - ys.at(i);
+        segment.length = std::sqrt(dx * dx + dy * dy);
+        if (segment.length == 0.0)
+        {
+            continue; // skip duplicate corner points
+        }
+        segment.dirX = dx / segment.length;
+        segment.dirY = dy / segment.length;
+        segment.start = _pixelLength;
+        _pixelLength += segment.length;
+        _segments.push_back(segment);
+    }
+
+    // degenerate street with both ends at the same place
+    if (_segments.empty() && !xs.empty())
+    {
+        _segments.push_back(Segment{xs.front(), ys.front(), 0.0, 0.0, 0.0, 0.0});
+    }
+
+    setLength(_length);
+}
+
+void StreetGeometry::setLength(double length)
+{
+    _length = length;
+    _pixelsPerMeter = _length > 0.0 ? _pixelLength / _length : 0.0;
+}
+
+void StreetGeometry::getPosition(double posStreet, bool isForward, size_t &segment, double &x, double &y) const
+{
+    // convert position in m along the driving direction into arc length in pixels from the 'in' intersection
+    double s = std::min(std::max(posStreet * _pixelsPerMeter, 0.0), _pixelLength);
+    if (!isForward)
+    {
+        s = _pixelLength - s;
+    }
+
+    // walk from the cached segment to the one containing s (forward when driving forward, backward otherwise)
+    requirePolyline();
+    segment = std::min(segment, _segments.size() - 1);
+    while (segment + 1 < _segments.size() && s > _segments[segment].start + _segments[segment].length)
+    {
+        segment++;
+    }
+    while (segment > 0 && s < _segments[segment].start)
+    {
+        segment--;
+    }
+
+    const Segment &seg = _segments[segment];
+    x = seg.x + (s - seg.start) * seg.dirX;
+    y = seg.y + (s - seg.start) * seg.dirY;
+}
+
+void StreetGeometry::getStartDirection(bool isForward, double &dx, double &dy) const
+{
+    requirePolyline();
+    const Segment &seg = isForward ? _segments.front() : _segments.back();
+    dx = isForward ? seg.dirX : -seg.dirX;
+    dy = isForward ? seg.dirY : -seg.dirY;
+}
+
+void StreetGeometry::getEndDirection(bool isForward, double &dx, double &dy) const
+{
+    requirePolyline();
+    const Segment &seg = isForward ? _segments.back() : _segments.front();
+    dx = isForward ? seg.dirX : -seg.dirX;
+    dy = isForward ? seg.dirY : -seg.dirY;
+}
+
+void StreetGeometry::requirePolyline() const
+{
+    // the shape is unknown until the street is connected at both ends
+    if (_segments.empty())
+        throw std::logic_error("street geometry used before both intersections have been connected");
+}
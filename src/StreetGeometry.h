@@ -0,0 +1,46 @@
+#ifndef STREETGEOMETRY_H
+#define STREETGEOMETRY_H
+
+#include <cstddef>
+#include <vector>
+
+// precomputed shape of a street as a polyline in pixel coordinates, from the 'in' to the 'out' intersection
+class StreetGeometry
+{
+public:
+    // constructor / destructor
+    StreetGeometry();
+
+    // getters / setters
+    void setPolyline(const std::vector<double> &xs, const std::vector<double> &ys); // corner points in driving order 'in' -> 'out'
+    void setLength(double length);                                                 // length in m used to scale between m and pixels
+    double getPixelLength() const { return _pixelLength; }
+    double getMetersPerPixel() const { return _pixelLength > 0.0 ? 1.0 / _pixelsPerMeter : 0.0; }
+
+    // typical behaviour methods, which throw std::logic_error as long as no polyline has been set
+    // pixel position of a vehicle which is posStreet m into the street, driving forward ('in' -> 'out') or backward.
+    // segment caches the polyline segment of the last lookup, so consecutive lookups only walk over the segments in between
+    void getPosition(double posStreet, bool isForward, size_t &segment, double &x, double &y) const;
+    // unit driving direction when leaving the start or arriving at the end of the street
+    void getStartDirection(bool isForward, double &dx, double &dy) const;
+    void getEndDirection(bool isForward, double &dx, double &dy) const;
+
+private:
+    // typical behaviour methods
+    void requirePolyline() const;
+
+    struct Segment
+    {
+        double x, y;       // start point in pixels
+        double dirX, dirY; // unit direction when driving forward, the backward direction is its negation
+        double start;      // arc length from the 'in' intersection to the start point in pixels
+        double length;     // length of the segment in pixels
+    };
+
+    std::vector<Segment> _segments;
+    double _pixelLength;    // arc length of the whole polyline in pixels
+    double _pixelsPerMeter; // scale between street length in m and polyline length in pixels
+    double _length;         // street length in m
+};
+
+#endif
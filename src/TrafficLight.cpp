@@ -3,65 +3,25 @@
 #include <chrono>  // to measure elapsed time
 #include "TrafficLight.h"
 
-/* Implementation of class "MessageQueue" */
-
-template <typename T>
-T MessageQueue<T>::receive()
-{
-    // This method waits for new objects in the queue and then pulls and returns the last object in it
-
-    // perform queue modification under the lock
-    std::unique_lock<std::mutex> uLock(_mtx);
-    // wait until the queue is not empty and then awake the thread, pass unique lock to condition variable
-    _cnd.wait(uLock, [this] { return !_queue.empty(); });
-
-    // access the last element (traffic light phase) in the queue and assign ownership of it to new variable 'msg'
-    T msg = std::move(_queue.back());
-    // remove the last element (traffic light phase) from the queue
-    _queue.pop_back();
-
-    return msg; // will not be copied due to return value optimization (RVO) in C++
-}
-
-template <typename T>
-void MessageQueue<T>::send(T &&msg)
-{
-    // This method adds an object to the queue and then notifys the client to unblock its thread.
-
-    // get a lock to perform queue modification under the lock
-    std::lock_guard<std::mutex> uLock(_mtx);
-
-    // add object to the queue transfering its ownership
-    _queue.push_back(std::move(msg));
-    // TO-DO: protect cout with shared mutex
-    std::cout << " Message " << msg << " has been sent to the queue" << std::endl;
-    // notify client to unblock a thread after having added an object to the queue
-    _cnd.notify_one();
-}
-
 /* Implementation of class "TrafficLight" */
-TrafficLight::TrafficLight(){
+TrafficLight::TrafficLight(std::shared_ptr<SimulationContext> context) : TrafficObject(context)
+{
     _currentPhase = TrafficLightPhase::red;
 }
 
 
 void TrafficLight::waitForGreen()
 {
-    // Run an infinite loop to repeatedly call the `receive` function on the MessageQueue object _msgQ
-    // Once a `TrafficLightPhase::green` object is received it exits the loop and the code execution continues
-
-    while(true){
-        // sleep at every iteration to reduce CPU usage
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-        TrafficLightPhase current_phase = _msgQ.receive();
-        if(current_phase == TrafficLightPhase::green){
-            return;
-        }
-    }
+    // Block until the light is green. Several vehicles may be crossing the intersection at the same time,
+    // so they wait on a condition variable which wakes all of them at once when the light turns green
+
+    std::unique_lock<std::mutex> lck(_mutex);
+    _condition.wait(lck, [this] { return _currentPhase == TrafficLightPhase::green; });
 }
 
 TrafficLightPhase TrafficLight::getCurrentPhase()
 {
+    std::lock_guard<std::mutex> lck(_mutex);
     return _currentPhase;
 }
 
@@ -78,24 +38,29 @@ void TrafficLight::cycleThroughPhases(){
     // Implements an infinite loop that measures the time between two loop cycles
     // and toggles the current phase of the traffic light between red and green
 
-    // construct a trivial random generator engine from a time-based seed
-    unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
+    // construct a trivial random generator engine from the scenario seed (time-based unless configured)
+    unsigned seed = _context->nextSeed();
     std::default_random_engine generator (seed);
-    std::uniform_int_distribution<int> distribution(4000,6000); // set range 4 to 6 milliseconds
-    // generate cycle duration (range set between 4000 to 6000 milliseconds)
+    const ScenarioConfig &config = _context->getConfig();
+    std::uniform_int_distribution<int> distribution(config.minCycleDuration, config.maxCycleDuration);
+    // generate cycle duration (range defaults to 4000 to 6000 milliseconds)
     int cycle_duration = distribution(generator); // set first cycle
     // initialize time measurement
     auto last_measurement = std::chrono::high_resolution_clock::now();
 
-    while(true){
+    while(_context->isRunning()){
         if (std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - last_measurement).count() > cycle_duration){
 
             // flip light: if red make it green, if green make it red
             int new_phase = abs(TrafficLight::getCurrentPhase() - 1);
-            // update value of _currentPhase variable, static_cast explicitly converts int value to enum type
-            _currentPhase = static_cast<TrafficLightPhase>(new_phase);
-            // push each new TrafficLightPhase into _msgQ calling its send method in conjunction with move semantics
-            _msgQ.send(std::move(_currentPhase));
+            setCurrentPhase(static_cast<TrafficLightPhase>(new_phase));
+
+            if (_context->isVerbose())
+            {
+                // protect cout with mutex shared by all traffic objects
+                std::lock_guard<std::mutex> lck(_context->getCoutMutex());
+                std::cout << " Traffic light switched to phase " << new_phase << std::endl;
+            }
 
             // generate next cycle duration (range was set 4 to 6 seconds)
             cycle_duration = distribution(generator);
@@ -106,4 +71,18 @@ void TrafficLight::cycleThroughPhases(){
        // sleep at every iteration to reduce CPU usage
        std::this_thread::sleep_for(std::chrono::milliseconds(1)); // 100 milliseconds = 0.1 second
     }
+
+    // leave the light green when the scenario shuts down so that no vehicle keeps waiting in waitForGreen()
+    setCurrentPhase(TrafficLightPhase::green);
+}
+
+void TrafficLight::setCurrentPhase(TrafficLightPhase phase)
+{
+    std::unique_lock<std::mutex> lck(_mutex);
+    // update value of _currentPhase variable
+    _currentPhase = phase;
+    lck.unlock();
+
+    // wake all vehicles waiting for green
+    _condition.notify_all();
 }
\ No newline at end of file
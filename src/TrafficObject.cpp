@@ -3,11 +3,6 @@
 #include <chrono>
 #include "TrafficObject.h"
 
-// init static variable
-int TrafficObject::_idCnt = 0;
-
-std::mutex TrafficObject::_mtx;
-
 void TrafficObject::setPosition(double x, double y)
 {
     _posX = x;
@@ -20,16 +15,22 @@ void TrafficObject::getPosition(double &x, double &y)
     y = _posY;
 }
 
-TrafficObject::TrafficObject()
+TrafficObject::TrafficObject(std::shared_ptr<SimulationContext> context) : _context(context)
 {
     _type = ObjectType::noObject;
-    _id = _idCnt++;
+    _id = _context->nextID();
 }
 
 TrafficObject::~TrafficObject()
 {
     // set up thread barrier before this object is destroyed
+    TrafficObject::joinThreads();
+}
+
+void TrafficObject::joinThreads()
+{
     std::for_each(threads.begin(), threads.end(), [](std::thread &t) {
         t.join();
     });
+    threads.clear();
 }
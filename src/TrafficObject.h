@@ -4,6 +4,8 @@
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <memory>
+#include "SimulationContext.h"
 
 enum ObjectType
 {
@@ -17,7 +19,7 @@ class TrafficObject
 {
 public:
     // constructor / desctructor
-    TrafficObject();
+    TrafficObject(std::shared_ptr<SimulationContext> context);
     ~TrafficObject();
 
     // getter and setter
@@ -28,16 +30,14 @@ public:
 
     // typical behaviour methods
     virtual void simulate(){};
+    virtual void joinThreads(); // wait for all threads launched within this object to finish
 
 protected:
     ObjectType _type;                 // identifies the class type
     int _id;                          // every traffic object has its own unique id
     double _posX, _posY;              // vehicle position in pixels
     std::vector<std::thread> threads; // holds all threads that have been launched within this object
-    static std::mutex _mtx;           // mutex shared by all traffic objects for protecting cout 
-
-private:
-    static int _idCnt; // global variable for counting object ids
+    std::shared_ptr<SimulationContext> _context; // scenario this object belongs to (object ids, cout mutex, run state)
 };
 
 #endif
\ No newline at end of file
@@ -1,155 +1,397 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 #include <thread>
+#include <tuple>
+#include <utility>
 #include <vector>
 
-#include "Vehicle.h"
-#include "Street.h"
-#include "Intersection.h"
+#include "Scenario.h"
+#include "Ensemble.h"
+#include "SimulationEngine.h"
+#include "EngineServer.h"
+#include "PartitionedSimulation.h"
+#include "NetworkGenerator.h"
+#include "FramePublisher.h"
+#include "VehicleRegistry.h"
 #include "Graphics.h"
+#include "Profiler.h"
 
+// split a comma separated command line value, e.g. "2,4,6"
+std::vector<std::string> splitList(const std::string &value)
+{
+    std::vector<std::string> items;
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        items.push_back(item);
+    }
+    return items;
+}
+
+// set by SIGINT and SIGTERM to end a run which publishes its frames
+volatile std::sig_atomic_t isStopRequested = 0;
 
-// Paris
-void createTrafficObjects_Paris(std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections, std::vector<std::shared_ptr<Vehicle>> &vehicles, std::string &filename, int nVehicles)
+void requestStop(int)
 {
-    // assign filename of corresponding city map
-    filename = "../data/paris.jpg";
+    isStopRequested = 1;
+}
 
-    // init traffic objects
-    int nIntersections = 9;
-    for (size_t ni = 0; ni < nIntersections; ni++)
+// parse a range of cycle durations in ms, e.g. "4000-6000", throws std::invalid_argument unless 0 < min <= max
+std::pair<int, int> parseCycleRange(const std::string &value)
+{
+    const std::string message = "invalid cycle range " + value + ", use min-max in ms with 0 < min <= max";
+    int minDuration, maxDuration;
+    try
     {
-        intersections.push_back(std::make_shared<Intersection>());
+        minDuration = std::stoi(value.substr(0, value.find('-')));
+        maxDuration = std::stoi(value.substr(value.find('-') + 1));
     }
-
-    // position intersections in pixel coordinates (counter-clockwise)
-    intersections.at(0)->setPosition(385, 270);
-    intersections.at(1)->setPosition(1240, 80);
-    intersections.at(2)->setPosition(1625, 75);
-    intersections.at(3)->setPosition(2110, 75);
-    intersections.at(4)->setPosition(2840, 175);
-    intersections.at(5)->setPosition(3070, 680);
-    intersections.at(6)->setPosition(2800, 1400);
-    intersections.at(7)->setPosition(400, 1100);
-    intersections.at(8)->setPosition(1700, 900); // central plaza
-
-    // create streets and connect traffic objects
-    int nStreets = 8;
-    for (size_t ns = 0; ns < nStreets; ns++)
+    catch (const std::logic_error &)
     {
-        streets.push_back(std::make_shared<Street>());
-        streets.at(ns)->setInIntersection(intersections.at(ns));
-        streets.at(ns)->setOutIntersection(intersections.at(8));
+        throw std::invalid_argument(message);
     }
+    if (minDuration <= 0 || minDuration > maxDuration)
+        throw std::invalid_argument(message);
+    return std::make_pair(minDuration, maxDuration);
+}
 
-    // add vehicles to streets
-    for (size_t nv = 0; nv < nVehicles; nv++)
+// parse a range of street lengths in m, e.g. "500-2000", throws std::invalid_argument unless 0 < min <= max
+std::pair<double, double> parseStreetLengthRange(const std::string &value)
+{
+    const std::string message = "invalid street length range " + value + ", use min-max in m with 0 < min <= max";
+    double minLength, maxLength;
+    try
     {
-        vehicles.push_back(std::make_shared<Vehicle>());
-        vehicles.at(nv)->setCurrentStreet(streets.at(nv));
-        vehicles.at(nv)->setCurrentDestination(intersections.at(8));
+        minLength = std::stod(value.substr(0, value.find('-')));
+        maxLength = std::stod(value.substr(value.find('-') + 1));
     }
+    catch (const std::logic_error &)
+    {
+        throw std::invalid_argument(message);
+    }
+    if (!(minLength > 0.0) || !(minLength <= maxLength) || !std::isfinite(maxLength)) // also rejects nan and inf
+        throw std::invalid_argument(message);
+    return std::make_pair(minLength, maxLength);
 }
 
-// NYC
-void createTrafficObjects_NYC(std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections, std::vector<std::shared_ptr<Vehicle>> &vehicles, std::string &filename, int nVehicles)
+// parse the mode of SimulationEngine, true for the discrete-event mode, throws std::invalid_argument unless steps or events
+bool parseEngineMode(const std::string &value)
+{
+    if (value != "steps" && value != "events")
+        throw std::invalid_argument("invalid engine mode " + value + ", use steps or events");
+    return value == "events";
+}
+
+/* Main function */
+int main(int argc, char *argv[])
 {
-    // assign filename of corresponding city map
-    filename = "../data/nyc.jpg";
+    /* PART 0 : Parse command line */
 
-    // init traffic objects
-    int nIntersections = 6;
-    for (size_t ni = 0; ni < nIntersections; ni++)
+    // usage: traffic_simulation [--map paris|nyc|grid:n|radial:n|planar:n] [--street-length min-max] [--degree d]
+    //                           [--vehicles n[,n...]] [--lanes n] [--motion constant|approach] [--routing random|straight]
+    //                           [--ensemble runs] [--cycle min-max[,min-max...]] [--duration s] [--workers n] [--seed s]
+    //                           [--platoon n] [--headway ms] [--trace file.json] [--server socket] [--engine steps|events]
+    //                           [--partitions n] [--heatmap cell] [--publish name]
+    ScenarioConfig config;
+    int nRuns = 0; // number of runs per parameter set, 0 launches the interactive simulation
+    int nWorkers = 0;
+    int nPartitions = 0; // number of processes sharing one scenario, 0 runs it in this process only
+    int heatmapCell = 0; // edge of a density cell in pixels, 0 draws every vehicle on its own
+    bool isEngineDriven = false; // interactive mode only: SimulationEngine instead of one thread per vehicle
+    std::string engineMode;      // steps or events, checked at startup
+    std::string streetLengths;   // range of street lengths of generated networks, checked at startup, empty keeps the default
+    std::string publishName;     // frames are published for traffic_viewer under this name instead of being drawn, empty draws them here
+    bool isDurationGiven = false; // a publishing run ends after --duration s instead of waiting for a signal
+    std::string traceFilename; // Chrome trace JSON written at the end of the run, empty disables profiling
+    std::string serverSocket;  // Unix socket on which an external controller steps the simulation, empty runs it in real time
+    std::vector<std::string> vehicleLevels{std::to_string(config.nVehicles)};
+    std::vector<std::string> cycleRanges{std::to_string(config.minCycleDuration) + "-" + std::to_string(config.maxCycleDuration)};
+    for (int i = 1; i + 1 < argc; i += 2)
     {
-        intersections.push_back(std::make_shared<Intersection>());
+        std::string option(argv[i]), value(argv[i + 1]);
+        if (option == "--map")
+            config.map = value;
+        else if (option == "--vehicles")
+            vehicleLevels = splitList(value);
+        else if (option == "--ensemble")
+            nRuns = std::stoi(value);
+        else if (option == "--cycle")
+            cycleRanges = splitList(value);
+        else if (option == "--duration")
+        {
+            config.duration = std::stod(value);
+            isDurationGiven = true;
+        }
+        else if (option == "--workers")
+            nWorkers = std::stoi(value);
+        else if (option == "--platoon")
+            config.platoonSize = std::stoi(value);
+        else if (option == "--headway")
+            config.saturationHeadway = std::stoi(value);
+        else if (option == "--lanes")
+            config.lanes = std::stoi(value);
+        else if (option == "--motion")
+            config.motionModel = value;
+        else if (option == "--routing")
+            config.routingPolicy = value;
+        else if (option == "--seed")
+            config.seed = std::stoul(value);
+        else if (option == "--trace")
+            traceFilename = value;
+        else if (option == "--server")
+            serverSocket = value;
+        else if (option == "--engine")
+        {
+            engineMode = value;
+            isEngineDriven = true;
+        }
+        else if (option == "--partitions")
+            nPartitions = std::stoi(value);
+        else if (option == "--street-length")
+            streetLengths = value;
+        else if (option == "--degree")
+            config.meanDegree = std::stod(value);
+        else if (option == "--heatmap")
+            heatmapCell = std::stoi(value);
+        else if (option == "--publish")
+            publishName = value;
+        else
+            std::cerr << "Ignoring unknown option " << option << std::endl;
     }
 
-    // position intersections in pixel coordinates
-    intersections.at(0)->setPosition(1430, 625);
-    intersections.at(1)->setPosition(2575, 1260);
-    intersections.at(2)->setPosition(2200, 1950);
-    intersections.at(3)->setPosition(1000, 1350);
-    intersections.at(4)->setPosition(400, 1000);
-    intersections.at(5)->setPosition(750, 250);
-
-    // create streets and connect traffic objects
-    int nStreets = 7;
-    for (size_t ns = 0; ns < nStreets; ns++)
+    // pick the compiled combination of motion model and routing policy once at startup and check the other options
+    std::vector<std::pair<int, int>> cycles;
+    try
     {
-        streets.push_back(std::make_shared<Street>());
+        for (auto &cycle : cycleRanges)
+        {
+            cycles.push_back(parseCycleRange(cycle));
+        }
+        if (isEngineDriven)
+            config.isEventDriven = parseEngineMode(engineMode);
+        if (!streetLengths.empty())
+            std::tie(config.minStreetLength, config.maxStreetLength) = parseStreetLengthRange(streetLengths);
+        findVehicleFactory(config.motionModel, config.routingPolicy);
+        if (NetworkGenerator::isGenerated(config.map))
+            NetworkGenerator::validate(config.map);
+    }
+    catch (const std::invalid_argument &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
     }
 
-    streets.at(0)->setInIntersection(intersections.at(0));
-    streets.at(0)->setOutIntersection(intersections.at(1));
-
-    streets.at(1)->setInIntersection(intersections.at(1));
-    streets.at(1)->setOutIntersection(intersections.at(2));
-
-    streets.at(2)->setInIntersection(intersections.at(2));
-    streets.at(2)->setOutIntersection(intersections.at(3));
+    // record timing zones of all threads from now on
+    Profiler::setEnabled(!traceFilename.empty());
+    auto exportTrace = [&traceFilename]() {
+        if (!traceFilename.empty() && !Profiler::exportChromeTrace(traceFilename))
+            std::cerr << "Could not write trace to " << traceFilename << std::endl;
+    };
 
-    streets.at(3)->setInIntersection(intersections.at(3));
-    streets.at(3)->setOutIntersection(intersections.at(4));
+    if (!serverSocket.empty())
+    {
+        /* Server mode : an external controller steps the simulation and reads its state from shared memory */
 
-    streets.at(4)->setInIntersection(intersections.at(4));
-    streets.at(4)->setOutIntersection(intersections.at(5));
+        config.nVehicles = std::stoi(vehicleLevels.front());
+        config.isVerbose = false;
+        Scenario scenario(config);
+        SimulationEngine engine(scenario);
+        try
+        {
+            EngineServer server(engine, serverSocket);
+            std::cout << "Waiting for controllers on " << serverSocket << ", state in shared memory " << server.getShmName() << std::endl;
+            server.run();
+        }
+        catch (const std::runtime_error &e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        exportTrace();
+        return 0;
+    }
 
-    streets.at(5)->setInIntersection(intersections.at(5));
-    streets.at(5)->setOutIntersection(intersections.at(0));
+    if (nPartitions > 0)
+    {
+        /* Partitioned mode : split the scenario across processes which exchange vehicles through shared memory */
 
-    streets.at(6)->setInIntersection(intersections.at(0));
-    streets.at(6)->setOutIntersection(intersections.at(3));
+        config.nVehicles = std::stoi(vehicleLevels.front());
+        config.isVerbose = false;
+        PartitionedSimulation simulation(config, nPartitions);
+        auto startTime = std::chrono::steady_clock::now();
+        try
+        {
+            SimulationStats stats = simulation.run();
+            double wallTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count() / 1000.0;
+            std::cout << "Partitioned run (" << nPartitions << " processes, lookahead " << simulation.getLookahead() << " s, "
+                      << wallTime << " s wall-clock) " << config.getLabel() << std::endl
+                      << "crossings=" << stats.crossings << " throughput=" << stats.getThroughput() << " veh/s"
+                      << " meanWait=" << stats.getMeanWaitTime() << " ms maxWait=" << stats.maxWaitTime << " ms" << std::endl;
+        }
+        catch (const std::runtime_error &e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        exportTrace();
+        return 0;
+    }
 
-    // add vehicles to streets
-    for (size_t nv = 0; nv < nVehicles; nv++)
+    if (nRuns > 0)
     {
-        vehicles.push_back(std::make_shared<Vehicle>());
-        vehicles.at(nv)->setCurrentStreet(streets.at(nv));
-        vehicles.at(nv)->setCurrentDestination(intersections.at(nv));
+        /* Ensemble mode : run all parameter combinations concurrently without visualization */
+
+        Ensemble ensemble;
+        if (nWorkers > 0)
+        {
+            ensemble.setNumWorkers(nWorkers);
+        }
+        config.isVerbose = false;
+        for (auto &vehicles : vehicleLevels)
+        {
+            for (auto &cycle : cycles)
+            {
+                ScenarioConfig sweep = config;
+                sweep.nVehicles = std::stoi(vehicles);
+                sweep.minCycleDuration = cycle.first;
+                sweep.maxCycleDuration = cycle.second;
+                for (int nr = 0; nr < nRuns; nr++)
+                {
+                    // give every replica its own seed so that they do not all see the same signal timings
+                    if (config.seed != 0)
+                    {
+                        sweep.seed = config.seed + 1000 * nr;
+                    }
+                    ensemble.addScenario(sweep);
+                }
+            }
+        }
+        ensemble.run();
+        ensemble.printReport(std::cout);
+        exportTrace();
+        return 0;
     }
-}
 
-/* Main function */
-int main()
-{
     /* PART 1 : Set up traffic objects */
 
     // create and connect intersections and streets
-    std::vector<std::shared_ptr<Street>> streets;
-    std::vector<std::shared_ptr<Intersection>> intersections;
-    std::vector<std::shared_ptr<Vehicle>> vehicles;
-    std::string backgroundImg;
-    int nVehicles = 6;
-    createTrafficObjects_Paris(streets, intersections, vehicles, backgroundImg, nVehicles);
+    config.nVehicles = std::stoi(vehicleLevels.front());
+    Scenario scenario(config);
 
     /* PART 2 : simulate traffic objects */
 
-    // start the simulation of all intersections, this will spawn each intersection's vehicle queue process in a new thread
-    std::for_each(intersections.begin(), intersections.end(), [](std::shared_ptr<Intersection> &i) {
-        i->simulate();
-    });
-
-    // start the simulation of all vehicles, this will spawn each vehicle's drive function in a separated thread
-    std::for_each(vehicles.begin(), vehicles.end(), [](std::shared_ptr<Vehicle> &v) {
-        v->simulate();
-    });
+    // start the simulation of all intersections and vehicles, each of which runs in its own threads,
+    // or let a SimulationEngine advanced by the drawing loop move them, which scales to far larger fleets
+    std::unique_ptr<SimulationEngine> engine;
+    if (isEngineDriven)
+        engine.reset(new SimulationEngine(scenario));
+    else
+        scenario.start();
 
     /* PART 3 : Launch visualization */
 
     // add all objects into common vector
-    std::vector<std::shared_ptr<TrafficObject>> trafficObjects;
-    std::for_each(intersections.begin(), intersections.end(), [&trafficObjects](std::shared_ptr<Intersection> &intersection) {
-        std::shared_ptr<TrafficObject> trafficObject = std::dynamic_pointer_cast<TrafficObject>(intersection);
-        trafficObjects.push_back(trafficObject);
-    });
-
-    std::for_each(vehicles.begin(), vehicles.end(), [&trafficObjects](std::shared_ptr<Vehicle> &vehicles) {
-        std::shared_ptr<TrafficObject> trafficObject = std::dynamic_pointer_cast<TrafficObject>(vehicles);
-        trafficObjects.push_back(trafficObject);
-    });
-
-    // draw all objects in vector
-    Graphics *graphics = new Graphics();
-    graphics->setBgFilename(backgroundImg);
-    graphics->setTrafficObjects(trafficObjects);
-    graphics->simulate();
+    std::vector<std::shared_ptr<TrafficObject>> trafficObjects = scenario.getTrafficObjects();
+
+    // frames show the traffic objects, or the state of the engine, which does not update them
+    FrameProvider collectFrame = [&trafficObjects](std::vector<FrameObject> &objects) {
+        FramePublisher::snapshot(trafficObjects, objects);
+    };
+    if (engine)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        collectFrame = [&engine, startTime](std::vector<FrameObject> &objects) {
+            // follow the wall clock, but simulate at most 100 ms per frame so that a slow engine does not fall ever further behind
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            long nSteps = std::min(std::lround(elapsed / SimulationEngine::stepDuration) - engine->getStepCount(),
+                                   std::lround(0.1 / SimulationEngine::stepDuration));
+            if (nSteps > 0)
+                engine->step(nSteps);
+
+            objects.clear();
+            for (const IntersectionState &intersection : engine->getIntersections())
+            {
+                FrameObject object{};
+                object.x = intersection.x;
+                object.y = intersection.y;
+                object.id = intersection.id;
+                object.type = frameIntersection;
+                object.isGreen = intersection.phase == TrafficLightPhase::green;
+                objects.push_back(object);
+            }
+            for (const VehicleState &vehicle : engine->getVehicles())
+            {
+                FrameObject object{};
+                object.x = vehicle.x;
+                object.y = vehicle.y;
+                object.id = vehicle.id;
+                object.type = frameVehicle;
+                objects.push_back(object);
+            }
+        };
+    }
+
+    // generated networks are drawn on a blank canvas
+    int canvasWidth, canvasHeight;
+    scenario.getCanvasSize(canvasWidth, canvasHeight);
+
+    if (!publishName.empty())
+    {
+        // leave the drawing to traffic_viewer processes, which attach to the published frames whenever they like
+        try
+        {
+            FramePublisher publisher(publishName, scenario.getIntersections().size() + scenario.getVehicles().size());
+            publisher.setBackground(scenario.getBackgroundImg(), canvasWidth, canvasHeight);
+            publisher.start(collectFrame);
+            std::cout << "Publishing frames as " << publishName << ", view them with traffic_viewer " << publishName << ", the run ends ";
+            if (isDurationGiven)
+                std::cout << "after " << config.duration << " s or ";
+            std::cout << "on SIGINT (Ctrl+C) or SIGTERM" << std::endl;
+
+            // wait without reading stdin, which returns at once for a run started in the background
+            std::signal(SIGINT, requestStop);
+            std::signal(SIGTERM, requestStop);
+            auto endTime = std::chrono::steady_clock::now() + std::chrono::duration<double>(config.duration);
+            while (!isStopRequested && (!isDurationGiven || std::chrono::steady_clock::now() < endTime))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            publisher.stop();
+        }
+        catch (const std::runtime_error &e)
+        {
+            std::cerr << e.what() << std::endl;
+            scenario.stop();
+            return 1;
+        }
+    }
+    else
+    {
+        // draw all objects in vector
+        Graphics *graphics = new Graphics();
+        graphics->setBgFilename(scenario.getBackgroundImg());
+        if (scenario.getBackgroundImg().empty())
+            graphics->setCanvasSize(canvasWidth, canvasHeight);
+        graphics->setTrafficObjects(trafficObjects);
+        graphics->setFrameProvider(collectFrame);
+        if (heatmapCell > 0)
+        {
+            graphics->setRenderMode(renderDensity);
+            graphics->setCellSize(heatmapCell);
+        }
+        graphics->simulate();
+
+        // ESC has been pressed in the simulation window
+        delete graphics;
+    }
+    scenario.stop();
+    exportTrace();
 }
@@ -0,0 +1,88 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FrameSubscriber.h"
+#include "Graphics.h"
+
+/* Main function of the viewer */
+int main(int argc, char *argv[])
+{
+    // usage: traffic_viewer name [--heatmap cell]
+    if (argc < 2)
+    {
+        std::cerr << "usage: traffic_viewer name [--heatmap cell], name as given to traffic_simulation --publish" << std::endl;
+        return 1;
+    }
+    std::string name(argv[1]);
+    int heatmapCell = 0;
+    for (int i = 2; i + 1 < argc; i += 2)
+    {
+        std::string option(argv[i]), value(argv[i + 1]);
+        if (option == "--heatmap")
+            heatmapCell = std::stoi(value);
+        else
+            std::cerr << "Ignoring unknown option " << option << std::endl;
+    }
+
+    // wait for the simulation to publish its first frame ring
+    std::unique_ptr<FrameSubscriber> subscriber;
+    while (!subscriber)
+    {
+        try
+        {
+            subscriber.reset(new FrameSubscriber(name));
+        }
+        catch (const std::runtime_error &e)
+        {
+            std::cout << "Waiting for frames published as " << name << " (" << e.what() << ")" << std::endl;
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+    }
+
+    Graphics *graphics = new Graphics();
+    int width, height;
+    subscriber->getCanvasSize(width, height);
+    graphics->setBgFilename(subscriber->getBackground());
+    graphics->setCanvasSize(width, height);
+    graphics->setWindowName("Traffic Viewer - " + name);
+    if (heatmapCell > 0)
+    {
+        graphics->setRenderMode(renderDensity);
+        graphics->setCellSize(heatmapCell);
+    }
+
+    // once the simulation has finished, keep showing its last frame and attach to the next one published under the same name
+    auto lastAttempt = std::chrono::steady_clock::now();
+    graphics->setFrameProvider([&](std::vector<FrameObject> &objects) {
+        if (subscriber->isClosed() && std::chrono::steady_clock::now() - lastAttempt > std::chrono::seconds(1))
+        {
+            lastAttempt = std::chrono::steady_clock::now();
+            try
+            {
+                std::unique_ptr<FrameSubscriber> next(new FrameSubscriber(name));
+                if (!next->isClosed())
+                {
+                    // the next run may show another map
+                    subscriber = std::move(next);
+                    subscriber->getCanvasSize(width, height);
+                    graphics->setBgFilename(subscriber->getBackground());
+                    graphics->setCanvasSize(width, height);
+                }
+            }
+            catch (const std::runtime_error &)
+            {
+            }
+        }
+        subscriber->read(objects);
+    });
+    graphics->simulate();
+
+    // ESC has been pressed in the viewer window
+    delete graphics;
+    return 0;
+}
@@ -11,11 +11,14 @@ class Vehicle : public TrafficObject, public std::enable_shared_from_this<Vehicl
 {
 public:
     // constructor / desctructor
-    Vehicle();
+    Vehicle(std::shared_ptr<SimulationContext> context);
 
     // getters / setters
-    void setCurrentStreet(std::shared_ptr<Street> street) { _currStreet = street; };
+    std::shared_ptr<Street> getCurrentStreet() { return _currStreet; }
+    void setCurrentStreet(std::shared_ptr<Street> street);
+    std::shared_ptr<Intersection> getCurrentDestination() { return _currDestination; }
     void setCurrentDestination(std::shared_ptr<Intersection> destination);
+    double getSpeed() { return _speed; }
 
     // typical behaviour methods
     void simulate();
@@ -23,14 +26,17 @@ public:
     // miscellaneous
     std::shared_ptr<Vehicle> get_shared_this() { return shared_from_this(); }
 
-private:
+protected:
     // typical behaviour methods
-    void drive();
+    virtual void drive() = 0; // implemented by VehicleModel for each combination of motion model and routing policy
+    void updateDrivingDirection();
 
     std::shared_ptr<Street> _currStreet;            // street on which the vehicle is currently on
     std::shared_ptr<Intersection> _currDestination; // destination to which the vehicle is currently driving
     double _posStreet;                              // position on current street
-    double _speed;                                  // ego speed in m/s
+    bool _isForward;                                // true when driving from the street's 'in' to its 'out' intersection
+    size_t _segment;                                // polyline segment of the current street the vehicle was last found on
+    double _speed;                                  // ego cruising speed in m/s
 };
 
 #endif
\ No newline at end of file
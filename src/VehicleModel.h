@@ -0,0 +1,150 @@
+#ifndef VEHICLEMODEL_H
+#define VEHICLEMODEL_H
+
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include "Street.h"
+#include "Intersection.h"
+#include "Vehicle.h"
+#include "Profiler.h"
+
+// vehicle whose drive loop is compiled for one combination of motion model and routing policy
+template <typename Motion, typename Routing>
+class VehicleModel final : public Vehicle
+{
+public:
+    // constructor / desctructor
+    VehicleModel(std::shared_ptr<SimulationContext> context) : Vehicle(context), _routing(context->nextSeed()) {}
+
+private:
+    // typical behaviour methods
+    void drive() override;
+
+    static constexpr long cycleDuration = 1; // duration of a single simulation cycle in ms
+
+    Routing _routing; // routing policy state, e.g. its random generator
+};
+
+// function which is executed in a thread
+template <typename Motion, typename Routing>
+void VehicleModel<Motion, Routing>::drive()
+{
+    // print id of the current thread
+    if (_context->isVerbose())
+    {
+        std::unique_lock<std::mutex> lck(_context->getCoutMutex());
+        std::cout << "Vehicle #" << _id << "::drive: thread id = " << std::this_thread::get_id() << std::endl;
+        lck.unlock();
+    }
+    Profiler::setThreadName("Vehicle #" + std::to_string(_id));
+
+    // initalize variables
+    bool hasEnteredIntersection = false;
+    double completion = 0.0;
+    std::shared_ptr<Street> nextStreet; // street chosen when queueing up in front of the current destination
+    std::chrono::time_point<std::chrono::system_clock> lastUpdate;
+
+    // init stop watch
+    lastUpdate = std::chrono::system_clock::now();
+    while (_context->isRunning())
+    {
+        // sleep at every iteration to reduce CPU usage
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        // compute time difference to stop watch
+        long timeSinceLastUpdate = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - lastUpdate).count();
+        if (timeSinceLastUpdate >= cycleDuration)
+        {
+            // update position with the speed given by the motion model
+            _posStreet += Motion::getSpeed(_speed, completion, hasEnteredIntersection) * timeSinceLastUpdate / 1000;
+
+            // compute completion rate of current street
+            completion = _posStreet / _currStreet->getLength();
+
+            // compute current pixel position on street based on driving direction,
+            // continuing the walk along the precomputed polyline from the segment of the last cycle
+            double xv, yv;
+            _currStreet->getGeometry().getPosition(_posStreet, _isForward, _segment, xv, yv);
+            this->setPosition(xv, yv);
+
+            // check whether halting position in front of destination has been reached
+            if (completion >= 0.9 && !hasEnteredIntersection)
+            {
+                // choose next street before queueing up, as the intersection admits vehicles per movement
+                std::vector<std::shared_ptr<Street>> streetOptions = _currDestination->queryStreets(_currStreet);
+                if (streetOptions.size() > 0)
+                {
+                    // let the routing policy pick one street and query intersection to enter this street
+                    nextStreet = _routing.chooseNextStreet(streetOptions, _currStreet, _currDestination);
+                }
+                else
+                {
+                    // this street is a dead-end, so drive back the same way
+                    nextStreet = _currStreet;
+                }
+
+                /* request entry to the current intersection (using async) */
+
+                // init a future object required to store the return type of the promise object that async automatically creates
+                // async also automatically creates a thread and passes the promise object to the thread
+
+                // In this implementation, async takes a reference to the method Intersection::addVehicleToQueue,
+                // the object _currDestination, a shared pointer to this using the get_shared_this() function
+                // and the streets the vehicle comes from and goes to.
+                // Once the execution of Intersection::addVehicleToQueue is completed
+                // std::async fulfills the promise and sets the promise as 'ready' (true)
+                // indicating that permission to enter has been granted
+
+                std::future<void> ftrEntryGranted;
+                {
+                    PROFILE_ZONE("Vehicle::spawnAsync");
+                    ftrEntryGranted = std::async(&Intersection::addVehicleToQueue, _currDestination, get_shared_this(), _currStreet, nextStreet);
+                }
+
+                // wait (block the execution) until the future is set as 'ready' (true) by async (entry has been granted)
+                // note: get() cannot be called several times on the same future (unlike wait() which can)
+                try
+                {
+                    PROFILE_ZONE("Vehicle::waitForEntry");
+                    ftrEntryGranted.get();
+                }
+                catch (const std::logic_error &e)
+                {
+                    // the vehicle is on a street which its destination does not know, so it can never be admitted;
+                    // take it off the road instead of letting the exception terminate the whole run
+                    std::lock_guard<std::mutex> lck(_context->getCoutMutex());
+                    std::cerr << "Vehicle #" << _id << " stops: " << e.what() << std::endl;
+                    return;
+                }
+
+                // set intersection flag, the motion model slows the vehicle down from now on
+                hasEnteredIntersection = true;
+            }
+
+            // check wether intersection has been crossed
+            if (completion >= 1.0 && hasEnteredIntersection)
+            {
+                // pick the one intersection at which the vehicle is currently not
+                std::shared_ptr<Intersection> nextIntersection = nextStreet->getInIntersection()->getID() == _currDestination->getID() ? nextStreet->getOutIntersection() : nextStreet->getInIntersection();
+
+                // send signal to intersection that vehicle has left the intersection
+                _currDestination->vehicleHasLeft(get_shared_this());
+
+                // assign new street and destination
+                this->setCurrentDestination(nextIntersection);
+                this->setCurrentStreet(nextStreet);
+
+                // reset intersection flag and completion rate for the new street
+                hasEnteredIntersection = false;
+                completion = 0.0;
+            }
+
+            // reset stop watch for next cycle
+            lastUpdate = std::chrono::system_clock::now();
+        }
+    } // eof simulation loop
+}
+
+#endif
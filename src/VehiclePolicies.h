@@ -0,0 +1,168 @@
+#ifndef VEHICLEPOLICIES_H
+#define VEHICLEPOLICIES_H
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+#include "Street.h"
+#include "Intersection.h"
+
+/*
+ * Motion models decide how fast a vehicle drives at a given point of its street.
+ * Routing policies decide which street a vehicle takes after crossing an intersection.
+ * Both are plugged into VehicleModel as template parameters, so every combination is
+ * compiled into its own drive loop without virtual calls per simulation cycle.
+ *
+ * Besides the speed at a point, motion models integrate their speed profile analytically: getTravelTime()
+ * returns the time needed to drive from one completion rate of a street to another and getCompletion()
+ * the completion rate reached after a given time, which lets the discrete-event mode of SimulationEngine
+ * skip vehicles between intersections.
+ */
+
+// constant velocity on the street, slowed down to a tenth of it inside the intersection
+struct ConstantVelocity
+{
+    static constexpr const char *name = "constant";
+    static constexpr double intersectionFactor = 0.1; // share of the cruising speed used while crossing
+
+    static constexpr double getSpeed(double cruiseSpeed, double, bool hasEnteredIntersection)
+    {
+        return hasEnteredIntersection ? cruiseSpeed * intersectionFactor : cruiseSpeed;
+    }
+
+    static double getTravelTime(double cruiseSpeed, double length, double fromCompletion, double toCompletion, bool hasEnteredIntersection)
+    {
+        return (toCompletion - fromCompletion) * length / getSpeed(cruiseSpeed, fromCompletion, hasEnteredIntersection);
+    }
+
+    static double getCompletion(double cruiseSpeed, double length, double fromCompletion, double time, bool hasEnteredIntersection)
+    {
+        return fromCompletion + getSpeed(cruiseSpeed, fromCompletion, hasEnteredIntersection) * time / length;
+    }
+};
+
+// constant velocity which decreases linearly while approaching the halting position in front of the destination
+struct DeceleratingApproach
+{
+    static constexpr const char *name = "approach";
+    static constexpr double intersectionFactor = 0.1; // share of the cruising speed used while crossing
+    static constexpr double brakingStart = 0.6;       // completion rate at which the vehicle starts to brake
+    static constexpr double brakingEnd = 0.9;         // completion rate of the halting position
+    static constexpr double approachFactor = 0.3;     // share of the cruising speed left at the halting position
+
+    static constexpr double getSpeed(double cruiseSpeed, double completion, bool hasEnteredIntersection)
+    {
+        if (hasEnteredIntersection)
+            return cruiseSpeed * intersectionFactor;
+        if (completion <= brakingStart)
+            return cruiseSpeed;
+        double braking = std::min(1.0, (completion - brakingStart) / (brakingEnd - brakingStart));
+        return cruiseSpeed * (1.0 - (1.0 - approachFactor) * braking);
+    }
+
+    // the speed profile is piecewise linear in the completion rate c: constant up to brakingStart, v(c) = V (1 - k (c - brakingStart))
+    // while braking and constant again after brakingEnd, so that dt = L dc / v(c) integrates to a logarithm while braking
+    static double getTravelTime(double cruiseSpeed, double length, double fromCompletion, double toCompletion, bool hasEnteredIntersection)
+    {
+        if (hasEnteredIntersection)
+            return (toCompletion - fromCompletion) * length / (cruiseSpeed * intersectionFactor);
+
+        double time = 0.0;
+        double c0 = std::min(fromCompletion, brakingStart), c1 = std::min(toCompletion, brakingStart);
+        time += (c1 - c0) * length / cruiseSpeed;
+        c0 = std::max(fromCompletion, brakingStart), c1 = std::min(toCompletion, brakingEnd);
+        if (c1 > c0)
+            time += length / (cruiseSpeed * brakingSlope) * std::log(getSpeed(cruiseSpeed, c0, false) / getSpeed(cruiseSpeed, c1, false));
+        c0 = std::max(fromCompletion, brakingEnd), c1 = std::max(toCompletion, brakingEnd);
+        time += (c1 - c0) * length / (cruiseSpeed * approachFactor);
+        return time;
+    }
+
+    static double getCompletion(double cruiseSpeed, double length, double fromCompletion, double time, bool hasEnteredIntersection)
+    {
+        if (hasEnteredIntersection)
+            return fromCompletion + cruiseSpeed * intersectionFactor * time / length;
+
+        // walk through the sections of the speed profile until the time is used up
+        double completion = fromCompletion;
+        if (completion < brakingStart)
+        {
+            double sectionTime = getTravelTime(cruiseSpeed, length, completion, brakingStart, false);
+            if (time <= sectionTime)
+                return completion + cruiseSpeed * time / length;
+            time -= sectionTime;
+            completion = brakingStart;
+        }
+        if (completion < brakingEnd)
+        {
+            double sectionTime = getTravelTime(cruiseSpeed, length, completion, brakingEnd, false);
+            if (time <= sectionTime)
+            {
+                double relativeSpeed = getSpeed(cruiseSpeed, completion, false) / cruiseSpeed * std::exp(-cruiseSpeed * brakingSlope * time / length);
+                return brakingStart + (1.0 - relativeSpeed) / brakingSlope;
+            }
+            time -= sectionTime;
+            completion = brakingEnd;
+        }
+        return completion + cruiseSpeed * approachFactor * time / length;
+    }
+
+private:
+    static constexpr double brakingSlope = (1.0 - approachFactor) / (brakingEnd - brakingStart); // k, relative speed lost per completion rate
+};
+
+// pick one of the outgoing streets at random
+class UniformRandomRouting
+{
+public:
+    static constexpr const char *name = "random";
+
+    UniformRandomRouting(unsigned int seed) : _eng(seed) {}
+
+    std::shared_ptr<Street> chooseNextStreet(const std::vector<std::shared_ptr<Street>> &streetOptions, const std::shared_ptr<Street> &, const std::shared_ptr<Intersection> &)
+    {
+        std::uniform_int_distribution<> distr(0, streetOptions.size() - 1);
+        return streetOptions.at(distr(_eng));
+    }
+
+private:
+    std::mt19937 _eng;
+};
+
+// pick the outgoing street which deviates least from the current driving direction
+class StraightAheadRouting
+{
+public:
+    static constexpr const char *name = "straight";
+
+    StraightAheadRouting(unsigned int) {}
+
+    std::shared_ptr<Street> chooseNextStreet(const std::vector<std::shared_ptr<Street>> &streetOptions, const std::shared_ptr<Street> &currStreet, const std::shared_ptr<Intersection> &currIntersection)
+    {
+        // driving direction when arriving at the intersection
+        double dxIn, dyIn;
+        bool isForwardIn = currStreet->getOutIntersection()->getID() == currIntersection->getID();
+        currStreet->getGeometry().getEndDirection(isForwardIn, dxIn, dyIn);
+
+        // the street whose initial direction is best aligned has the largest dot product
+        std::shared_ptr<Street> bestStreet = streetOptions.front();
+        double bestAlignment = -2.0;
+        for (auto &street : streetOptions)
+        {
+            double dxOut, dyOut;
+            bool isForwardOut = street->getInIntersection()->getID() == currIntersection->getID();
+            street->getGeometry().getStartDirection(isForwardOut, dxOut, dyOut);
+            double alignment = dxIn * dxOut + dyIn * dyOut;
+            if (alignment > bestAlignment)
+            {
+                bestAlignment = alignment;
+                bestStreet = street;
+            }
+        }
+        return bestStreet;
+    }
+};
+
+#endif
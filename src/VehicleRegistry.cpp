@@ -0,0 +1,58 @@
+#include <stdexcept>
+#include "VehiclePolicies.h"
+#include "VehicleModel.h"
+#include "EngineKernel.h"
+#include "VehicleRegistry.h"
+
+template <typename Motion, typename Routing>
+std::shared_ptr<Vehicle> makeVehicle(std::shared_ptr<SimulationContext> context)
+{
+    return std::make_shared<VehicleModel<Motion, Routing>>(context);
+}
+
+template <typename Motion, typename Routing>
+std::unique_ptr<EngineKernel> makeKernel(const EngineNetwork &network)
+{
+    return std::unique_ptr<EngineKernel>(new EngineKernelModel<Motion, Routing>(network));
+}
+
+template <typename Motion, typename Routing>
+VehicleModelEntry makeEntry()
+{
+    return VehicleModelEntry{Motion::name, Routing::name, &makeVehicle<Motion, Routing>, &makeKernel<Motion, Routing>, &Motion::getTravelTime};
+}
+
+const std::vector<VehicleModelEntry> &getVehicleModels()
+{
+    // every combination listed here is instantiated as its own drive loop
+    static const std::vector<VehicleModelEntry> models{
+        makeEntry<ConstantVelocity, UniformRandomRouting>(),
+        makeEntry<ConstantVelocity, StraightAheadRouting>(),
+        makeEntry<DeceleratingApproach, UniformRandomRouting>(),
+        makeEntry<DeceleratingApproach, StraightAheadRouting>(),
+    };
+    return models;
+}
+
+const VehicleModelEntry &findVehicleModel(const std::string &motionModel, const std::string &routingPolicy)
+{
+    for (auto &model : getVehicleModels())
+    {
+        if (motionModel == model.motionModel && routingPolicy == model.routingPolicy)
+        {
+            return model;
+        }
+    }
+
+    std::string available;
+    for (auto &model : getVehicleModels())
+    {
+        available += std::string(" ") + model.motionModel + "/" + model.routingPolicy;
+    }
+    throw std::invalid_argument("unknown vehicle model " + motionModel + "/" + routingPolicy + ", available:" + available);
+}
+
+VehicleFactory findVehicleFactory(const std::string &motionModel, const std::string &routingPolicy)
+{
+    return findVehicleModel(motionModel, routingPolicy).factory;
+}
@@ -0,0 +1,37 @@
+#ifndef VEHICLEREGISTRY_H
+#define VEHICLEREGISTRY_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "SimulationContext.h"
+
+// forward declarations to avoid include cycle
+class Vehicle;
+class EngineKernel;
+struct EngineNetwork;
+
+typedef std::shared_ptr<Vehicle> (*VehicleFactory)(std::shared_ptr<SimulationContext> context);
+typedef std::unique_ptr<EngineKernel> (*EngineKernelFactory)(const EngineNetwork &network);
+typedef double (*TravelTimeFunction)(double cruiseSpeed, double length, double fromCompletion, double toCompletion, bool hasEnteredIntersection);
+
+// one compiled combination of motion model and routing policy
+struct VehicleModelEntry
+{
+    const char *motionModel;
+    const char *routingPolicy;
+    VehicleFactory factory;            // threaded vehicle (VehicleModel)
+    EngineKernelFactory kernelFactory; // vehicle kernel of the stepped SimulationEngine (EngineKernelModel)
+    TravelTimeFunction travelTime;     // time the motion model needs between two completion rates of a street in s
+};
+
+// look up the combination selected at startup, throws std::invalid_argument for unknown names
+const VehicleModelEntry &findVehicleModel(const std::string &motionModel, const std::string &routingPolicy);
+
+// shorthand for findVehicleModel(motionModel, routingPolicy).factory
+VehicleFactory findVehicleFactory(const std::string &motionModel, const std::string &routingPolicy);
+
+// list of all compiled combinations
+const std::vector<VehicleModelEntry> &getVehicleModels();
+
+#endif
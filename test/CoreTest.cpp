@@ -0,0 +1,468 @@
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "RingBuffer.h"
+#include "ConflictMatrix.h"
+#include "MovementQueues.h"
+#include "Scenario.h"
+#include "SimulationEngine.h"
+#include "PartitionedSimulation.h"
+
+/* Checks of the simulation library without OpenCV, run by ctest (see CMakeLists.txt) */
+
+static int failureCnt = 0;
+
+// report a failed condition and carry on, so that one run lists all failures
+#define CHECK(condition)                                                                      \
+    do                                                                                        \
+    {                                                                                         \
+        if (!(condition))                                                                     \
+        {                                                                                     \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            failureCnt++;                                                                     \
+        }                                                                                     \
+    } while (false)
+
+// small deterministic scenario for the engine checks
+static ScenarioConfig makeConfig(const std::string &map, int nVehicles)
+{
+    ScenarioConfig config;
+    config.map = map;
+    config.nVehicles = nVehicles;
+    config.seed = 42;
+    config.isVerbose = false;
+    return config;
+}
+
+// four legs leaving east, south, west and north (atan2 in pixel coordinates, y pointing down)
+static ConflictMatrix makeCrossing()
+{
+    ConflictMatrix conflicts;
+    conflicts.build({0.0, M_PI / 2, M_PI, -M_PI / 2});
+    return conflicts;
+}
+
+static void testRingBuffer()
+{
+    // pop some elements first, so that growing has to unwrap a buffer whose front is not at slot 0
+    RingBuffer<std::unique_ptr<int>> buffer;
+    int nextPushed = 0, nextPopped = 0;
+    for (; nextPushed < 6; nextPushed++)
+    {
+        buffer.push_back(std::unique_ptr<int>(new int(nextPushed)));
+    }
+    for (; nextPopped < 4; nextPopped++)
+    {
+        CHECK(*buffer.front() == nextPopped);
+        buffer.pop_front();
+    }
+    for (; nextPushed < 40; nextPushed++)
+    {
+        buffer.push_back(std::unique_ptr<int>(new int(nextPushed)));
+    }
+    CHECK(buffer.size() == 36);
+    CHECK(*buffer.at(35) == 39);
+
+    // a moved buffer keeps the order, the source is empty
+    RingBuffer<std::unique_ptr<int>> moved(std::move(buffer));
+    CHECK(buffer.empty());
+    for (; !moved.empty(); nextPopped++)
+    {
+        CHECK(*moved.front() == nextPopped);
+        moved.pop_front();
+    }
+    CHECK(nextPopped == 40);
+
+    // elements still queued are destroyed with the buffer
+    auto tracked = std::make_shared<int>(0);
+    {
+        RingBuffer<std::shared_ptr<int>> owner;
+        for (int i = 0; i < 9; i++)
+        {
+            owner.push_back(std::shared_ptr<int>(tracked));
+        }
+        owner.pop_front();
+        CHECK(tracked.use_count() == 9);
+    }
+    CHECK(tracked.use_count() == 1);
+}
+
+static void testConflictMatrix()
+{
+    const int east = 0, south = 1, west = 2, north = 3;
+    ConflictMatrix conflicts = makeCrossing();
+    CHECK(conflicts.getNumLegs() == 4);
+    CHECK(conflicts.getFromLeg(conflicts.getMovement(west, north)) == west);
+
+    // opposing straight-through movements pass each other, crossing ones do not
+    int eastbound = conflicts.getMovement(west, east), westbound = conflicts.getMovement(east, west);
+    int southbound = conflicts.getMovement(north, south);
+    CHECK(!conflicts.isConflicting(eastbound, westbound));
+    CHECK(conflicts.isConflicting(eastbound, southbound));
+
+    // of the two turns from the east leg, only the one across the opposing traffic conflicts with it
+    bool isTurnSouthConflicting = conflicts.isConflicting(conflicts.getMovement(east, south), eastbound);
+    bool isTurnNorthConflicting = conflicts.isConflicting(conflicts.getMovement(east, north), eastbound);
+    CHECK(isTurnSouthConflicting != isTurnNorthConflicting);
+
+    // the opposite turns which do not cross any traffic do not conflict with each other either
+    int rightTurnEast = isTurnSouthConflicting ? conflicts.getMovement(east, north) : conflicts.getMovement(east, south);
+    int rightTurnWest = isTurnSouthConflicting ? conflicts.getMovement(west, south) : conflicts.getMovement(west, north);
+    CHECK(!conflicts.isConflicting(rightTurnEast, rightTurnWest));
+
+    // merging into the same street always conflicts, movements from the same leg never
+    CHECK(conflicts.isConflicting(conflicts.getMovement(north, west), conflicts.getMovement(south, west)));
+    CHECK(!conflicts.isConflicting(conflicts.getMovement(east, west), conflicts.getMovement(east, north)));
+
+    // the relation is symmetric
+    for (int a = 0; a < conflicts.getNumMovements(); a++)
+    {
+        for (int b = 0; b < conflicts.getNumMovements(); b++)
+        {
+            CHECK(conflicts.isConflicting(a, b) == conflicts.isConflicting(b, a));
+        }
+    }
+}
+
+static void testMovementQueues()
+{
+    const int east = 0, south = 1, west = 2, north = 3;
+    std::vector<int> permitted, slots;
+    auto permit = [&permitted, &slots](int &&vehicle, int slot) {
+        permitted.push_back(vehicle);
+        slots.push_back(slot);
+    };
+
+    // a platoon holds at most platoonSize vehicles per lane, the next one starts once a vehicle has left
+    MovementQueues<int> queues;
+    queues.setLayout(makeCrossing(), {1, 1, 1, 1});
+    for (int vehicle = 0; vehicle < 5; vehicle++)
+    {
+        int item = vehicle;
+        queues.push(vehicle, std::move(item), east, west);
+    }
+    CHECK(queues.popPlatoons(3, permit) == 3);
+    CHECK((permitted == std::vector<int>{0, 1, 2}));
+    CHECK((slots == std::vector<int>{0, 1, 2}));
+    CHECK(queues.getSize() == 2 && queues.getNumActive() == 3);
+    CHECK(queues.popPlatoons(3, permit) == 0);
+    queues.release(0);
+    CHECK(queues.popPlatoons(3, permit) == 1);
+    CHECK(permitted.back() == 3 && slots.back() == 0);
+
+    // crossing traffic waits while the westbound movement is in use, opposing traffic goes along
+    int southbound = 10, eastbound = 11;
+    queues.push(southbound, std::move(southbound), north, south);
+    queues.push(eastbound, std::move(eastbound), west, east);
+    permitted.clear();
+    queues.popPlatoons(3, permit);
+    CHECK((permitted == std::vector<int>{11}));
+    for (int vehicle : {1, 2, 3, 11})
+    {
+        queues.release(vehicle);
+    }
+    permitted.clear();
+    queues.popPlatoons(3, permit);
+    CHECK((permitted == std::vector<int>{4}));
+    queues.release(4);
+    permitted.clear();
+    queues.popPlatoons(3, permit);
+    CHECK((permitted == std::vector<int>{10}));
+
+    // on a single lane the first vehicle to arrive blocks the ones behind it, on two lanes they pass it
+    for (int lanes = 1; lanes <= 2; lanes++)
+    {
+        MovementQueues<int> blocking;
+        blocking.setLayout(makeCrossing(), {lanes, lanes, lanes, lanes});
+        int crossing = 0, merging = 1, turning = 2;
+        blocking.push(crossing, std::move(crossing), north, south);
+        blocking.popPlatoons(1, permit);
+        blocking.push(merging, std::move(merging), east, south);
+        blocking.push(turning, std::move(turning), east, north);
+        permitted.clear();
+        slots.clear();
+        blocking.popPlatoons(4, permit);
+        if (lanes == 1)
+            CHECK(permitted.empty());
+        else
+            CHECK((permitted == std::vector<int>{2}));
+    }
+
+    // vehicles on parallel lanes share their slot
+    MovementQueues<int> parallel;
+    parallel.setLayout(makeCrossing(), {2, 2, 2, 2});
+    for (int vehicle = 0; vehicle < 4; vehicle++)
+    {
+        int item = vehicle;
+        parallel.push(vehicle, std::move(item), south, north);
+    }
+    slots.clear();
+    CHECK(parallel.popPlatoons(8, permit) == 4);
+    CHECK((slots == std::vector<int>{0, 0, 1, 1}));
+
+    // emptying the queues ignores all conflicts
+    int waiting = 20;
+    parallel.push(waiting, std::move(waiting), east, north);
+    permitted.clear();
+    parallel.popAll(permit);
+    CHECK((permitted == std::vector<int>{20}));
+    CHECK(parallel.getSize() == 0);
+}
+
+static void testEngineCommands()
+{
+    Scenario scenario(makeConfig("grid:4", 0), false);
+    SimulationEngine engine(scenario);
+
+    // a rejected batch leaves nothing behind
+    CommandBuffer invalid;
+    invalid.setPhase(0, TrafficLightPhase::green);
+    invalid.setPhase(4, TrafficLightPhase::green);
+    bool isRejected = false;
+    try
+    {
+        engine.submit(invalid);
+    }
+    catch (const std::out_of_range &)
+    {
+        isRejected = true;
+    }
+    CHECK(isRejected);
+    engine.step(10);
+    CHECK(!engine.getIntersections()[0].isExternallyControlled);
+
+    // a light taken over keeps its phase beyond the longest cycle until it is handed back
+    CommandBuffer commands;
+    commands.setPhase(0, TrafficLightPhase::green);
+    engine.submit(commands);
+    engine.step(7000);
+    CHECK(engine.getIntersections()[0].phase == TrafficLightPhase::green);
+    CHECK(engine.getIntersections()[0].isExternallyControlled);
+    commands.clear();
+    commands.releasePhase(0);
+    engine.submit(commands);
+    engine.step(6100);
+    CHECK(engine.getIntersections()[0].phase == TrafficLightPhase::red);
+
+    // an injected vehicle drives along its street and crosses its destination
+    commands.clear();
+    commands.setPhase(1, TrafficLightPhase::green);
+    commands.injectVehicle(0, 1);
+    engine.submit(commands);
+    engine.step(5000);
+    CHECK(engine.getVehicles().size() == 1);
+    CHECK(engine.getStats().crossings >= 1);
+}
+
+static void testEventQueue()
+{
+    ScenarioConfig config = makeConfig("grid:4", 0);
+    config.isEventDriven = true;
+    Scenario scenario(config, false);
+    SimulationEngine engine(scenario);
+
+    // a light taken over at 0.5 s must not change when its own cycle would have ended
+    engine.step(500);
+    CommandBuffer commands;
+    commands.setPhase(0, TrafficLightPhase::green);
+    engine.submit(commands);
+    engine.step(2000);
+    CHECK(engine.getIntersections()[0].phase == TrafficLightPhase::green);
+
+    // handed back at 2.5 s, the light changes once its new cycle has ended and not at the outdated one
+    commands.clear();
+    commands.releasePhase(0);
+    engine.submit(commands);
+    engine.step(1);
+    double cycleEnd = 2.5 + engine.getIntersections()[0].cycleDuration;
+    engine.step(std::lround((cycleEnd - engine.getTime()) / SimulationEngine::stepDuration) - 1);
+    CHECK(engine.getIntersections()[0].phase == TrafficLightPhase::green);
+    engine.step(2);
+    CHECK(engine.getIntersections()[0].phase == TrafficLightPhase::red);
+
+    // simultaneous events are processed in a fixed order, so equal engines stay equal,
+    // and no event beyond the end of a step is processed ahead of time
+    config.nVehicles = 30;
+    Scenario scenarioA(config, false), scenarioB(config, false);
+    SimulationEngine engineA(scenarioA), engineB(scenarioB);
+    for (int n = 0; n < 20; n++)
+    {
+        engineA.step(500);
+        engineB.step(250);
+        engineB.step(250);
+        StateView<VehicleState> vehiclesA = engineA.getVehicles(), vehiclesB = engineB.getVehicles();
+        CHECK(vehiclesA.size() == vehiclesB.size());
+        for (size_t nv = 0; nv < vehiclesA.size() && nv < vehiclesB.size(); nv++)
+        {
+            CHECK(vehiclesA[nv].status == vehiclesB[nv].status && vehiclesA[nv].street == vehiclesB[nv].street);
+            CHECK(std::abs(vehiclesA[nv].completion - vehiclesB[nv].completion) < 1e-9);
+            CHECK(vehiclesA[nv].updateTime <= engineA.getTime() + 1e-9);
+        }
+    }
+    CHECK(engineA.getEventCount() > 0);
+    CHECK(engineA.getStats().crossings == engineB.getStats().crossings);
+}
+
+// run a scenario in the stepped or the discrete-event mode
+static SimulationStats runEngine(ScenarioConfig config, bool isEventDriven, long nSteps)
+{
+    config.isEventDriven = isEventDriven;
+    Scenario scenario(config, false);
+    SimulationEngine engine(scenario);
+    engine.step(nSteps);
+    return engine.getStats();
+}
+
+static void testEngineModes()
+{
+    // a single vehicle on green lights reaches, queues at and crosses its destination at the same time in both modes
+    double queuedTimes[2] = {0.0, 0.0};
+    for (int mode = 0; mode < 2; mode++)
+    {
+        ScenarioConfig config = makeConfig("grid:4", 0);
+        config.isEventDriven = mode == 1;
+        Scenario scenario(config, false);
+        SimulationEngine engine(scenario);
+        CommandBuffer commands;
+        for (int ni = 0; ni < 4; ni++)
+        {
+            commands.setPhase(ni, TrafficLightPhase::green);
+        }
+        commands.injectVehicle(0, 1);
+        engine.submit(commands);
+        engine.step(3000);
+        queuedTimes[mode] = engine.getVehicles()[0].queuedTime;
+        CHECK(engine.getStats().crossings >= 1);
+        CHECK(engine.getStats().maxWaitTime < 2.0); // ms, nothing to wait for
+    }
+    CHECK(queuedTimes[0] > 0.0);
+    CHECK(std::abs(queuedTimes[0] - queuedTimes[1]) <= 2 * SimulationEngine::stepDuration);
+
+    // with traffic, a vehicle whose slot coincides with a light change may be let in before the change in one mode
+    // and a cycle later in the other, so only the statistics of several scenarios are compared
+    SimulationStats stepped, events;
+    for (unsigned int seed : {1u, 2u, 42u})
+    {
+        ScenarioConfig config = makeConfig("grid:100", 200);
+        config.seed = seed;
+        stepped.merge(runEngine(config, false, 20000));
+        events.merge(runEngine(config, true, 20000));
+    }
+    CHECK(stepped.crossings > 1000);
+    CHECK(std::abs(events.crossings - stepped.crossings) < 0.05 * stepped.crossings);
+    CHECK(std::abs(events.getMeanWaitTime() - stepped.getMeanWaitTime()) < 0.1 * stepped.getMeanWaitTime());
+}
+
+static void testPartitionHandoff()
+{
+    // two engines splitting a grid exchange their handoffs once per window, like the processes of a PartitionedSimulation;
+    // a vehicle taken over catches up on the steps since it has left, so both move every vehicle like one engine owning all
+    for (int mode = 0; mode < 2; mode++)
+    {
+        ScenarioConfig config = makeConfig("grid:16", 40);
+        config.routingPolicy = "straight";
+        config.isEventDriven = mode == 1;
+        Scenario whole(config, false), left(config, false), right(config, false);
+        std::vector<int> owners = PartitionedSimulation::partitionIntersections(whole.getIntersections(), 2);
+        std::vector<bool> isLeft, isRight;
+        for (int owner : owners)
+        {
+            isLeft.push_back(owner == 0);
+            isRight.push_back(owner == 1);
+        }
+        SimulationEngine reference(whole), engineLeft(left, isLeft), engineRight(right, isRight);
+        CHECK(engineLeft.getIntersections().size() + engineRight.getIntersections().size() == reference.getIntersections().size());
+
+        long nHandoffs = 0;
+        for (int nw = 0; nw < 30; nw++)
+        {
+            // a window well below the lookahead of 2.25 s on 1000 m streets
+            reference.step(500);
+            engineLeft.step(500);
+            engineRight.step(500);
+            std::vector<VehicleHandoff> toRight = engineLeft.takeHandoffs(), toLeft = engineRight.takeHandoffs();
+            for (auto &handoff : toRight)
+            {
+                CHECK(owners[handoff.destination] == 1 && handoff.time <= engineRight.getTime());
+                engineRight.acceptVehicle(handoff);
+            }
+            for (auto &handoff : toLeft)
+            {
+                CHECK(owners[handoff.destination] == 0 && handoff.time <= engineLeft.getTime());
+                engineLeft.acceptVehicle(handoff);
+            }
+            nHandoffs += toRight.size() + toLeft.size();
+
+            // every vehicle is simulated by exactly one partition, where it is as far as in the reference
+            std::map<int, VehicleState> partitioned;
+            for (SimulationEngine *engine : {&engineLeft, &engineRight})
+            {
+                for (const VehicleState &vehicle : engine->getVehicles())
+                {
+                    if (vehicle.status != vehicleInactive)
+                        CHECK(partitioned.emplace(vehicle.id, vehicle).second);
+                }
+            }
+            CHECK(partitioned.size() == reference.getVehicles().size());
+            for (const VehicleState &vehicle : reference.getVehicles())
+            {
+                auto found = partitioned.find(vehicle.id);
+                CHECK(found != partitioned.end());
+                if (found == partitioned.end())
+                    continue;
+                CHECK(found->second.status == vehicle.status && found->second.street == vehicle.street && found->second.destination == vehicle.destination);
+                CHECK(std::abs(found->second.completion - vehicle.completion) < 1e-6);
+            }
+        }
+        CHECK(nHandoffs > 0);
+        CHECK(engineLeft.getStats().crossings + engineRight.getStats().crossings == reference.getStats().crossings);
+    }
+}
+
+static void testPartitions()
+{
+    // splitting a scenario between processes does not change its outcome
+    for (int mode = 0; mode < 2; mode++)
+    {
+        ScenarioConfig config = makeConfig("grid:100", 300);
+        config.routingPolicy = "straight"; // a vehicle taken over by another partition gets a new routing seed
+        config.isEventDriven = mode == 1;
+        config.duration = 20.0;
+        SimulationStats single = PartitionedSimulation(config, 1).run();
+        CHECK(single.crossings > 500);
+        for (int nPartitions : {2, 3, 5})
+        {
+            PartitionedSimulation simulation(config, nPartitions);
+            SimulationStats stats = simulation.run();
+            CHECK(std::abs(simulation.getLookahead() - 2.25) < 1e-9); // 1000 m streets up to the halting position at 400 m/s
+            CHECK(stats.crossings == single.crossings);
+            CHECK(std::abs(stats.totalWaitTime - single.totalWaitTime) < 1e-9 * single.totalWaitTime);
+            CHECK(stats.maxWaitTime == single.maxWaitTime);
+        }
+    }
+}
+
+int main()
+{
+    testRingBuffer();
+    testConflictMatrix();
+    testMovementQueues();
+    testEngineCommands();
+    testEventQueue();
+    testEngineModes();
+    testPartitionHandoff();
+    testPartitions();
+
+    if (failureCnt > 0)
+    {
+        std::cerr << failureCnt << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all checks passed" << std::endl;
+    return 0;
+}